@@ -0,0 +1,323 @@
+#include "alerts.hpp"
+
+#include "units.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fnmatch.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// --- AlertRule ---
+
+bool AlertRule::matches(const std::string& device) const {
+    if (pattern.find('/') != std::string::npos) return ::fnmatch(pattern.c_str(), device.c_str(), 0) == 0;
+    size_t slash = device.rfind('/');
+    const char* name = device.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    return ::fnmatch(pattern.c_str(), name, 0) == 0;
+}
+
+// --- AlertQueue ---
+
+// Vyukov's bounded queue: each cell's sequence number says whether it is
+// free for the push at that position or holds the event for the pop there.
+AlertQueue::AlertQueue() : cells_(std::make_unique<Cell[]>(kCapacity)) {
+    for (size_t i = 0; i < kCapacity; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool AlertQueue::push(const AlertEvent& event) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &cells_[pos & (kCapacity - 1)];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->event = event;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool AlertQueue::pop(AlertEvent& out) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos & (kCapacity - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+    out = cell.event;
+    head_.store(pos + 1, std::memory_order_relaxed);
+    cell.sequence.store(pos + kCapacity, std::memory_order_release);
+    return true;
+}
+
+// --- AlertEngine ---
+
+static bool parse_rule(const std::vector<std::string>& words, AlertRule& rule, std::string& problem) {
+    if (words.size() < 5) {
+        problem = "expected <name> <device> <metric> <condition> <threshold>";
+        return false;
+    }
+    rule.name = words[0];
+    rule.pattern = words[1];
+    rule.metric = paths().key(words[2]);
+
+    const std::string& op = words[3];
+    if (op == ">" || op == "<") {
+        rule.above = op == ">";
+    } else if (op == "rate>" || op == "rate<") {
+        rule.above = op == "rate>";
+        rule.rate = true;
+    } else {
+        problem = "unknown condition '" + op + "' (>, <, rate> or rate<)";
+        return false;
+    }
+    if (!parse_i64(words[4], rule.threshold)) {
+        problem = "invalid threshold '" + words[4] + "'";
+        return false;
+    }
+    rule.clear = rule.threshold;
+
+    for (size_t i = 5; i < words.size(); ++i) {
+        const std::string& option = words[i];
+        int64_t value = 0;
+        if (option.rfind("clear=", 0) == 0 && parse_i64(option.substr(6), value)) {
+            rule.clear = value;
+        } else if (option.rfind("for=", 0) == 0 && parse_i64(option.substr(4), value) && value >= 1) {
+            rule.hold = static_cast<unsigned>(value);
+        } else {
+            problem = "invalid option '" + option + "' (clear=<value> or for=<samples>)";
+            return false;
+        }
+    }
+    if (rule.above ? rule.clear > rule.threshold : rule.clear < rule.threshold) {
+        problem = "clear=" + std::to_string(rule.clear) + " is past the threshold";
+        return false;
+    }
+    return true;
+}
+
+bool AlertEngine::load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::vector<AlertRule> rules;
+    int number = 0;
+    for (std::string line; std::getline(file, line);) {
+        ++number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        std::vector<std::string> words;
+        for (std::string word; in >> word;) words.push_back(std::move(word));
+        if (words.empty()) continue;
+
+        AlertRule rule;
+        std::string problem;
+        if (!parse_rule(words, rule, problem)) {
+            error = path + ":" + std::to_string(number) + ": " + problem;
+            return false;
+        }
+        rules.push_back(std::move(rule));
+    }
+    rules_ = std::move(rules);
+    return true;
+}
+
+bool AlertEngine::watches(const std::string& device) const {
+    for (const auto& rule : rules_) {
+        if (rule.matches(device)) return true;
+    }
+    return false;
+}
+
+void AlertEngine::add_sink(AlertQueue* queue, std::function<void()> notify) {
+    sinks_.push_back({queue, std::move(notify)});
+}
+
+void AlertEngine::bind(const std::vector<Binding>& targets) {
+    std::map<std::pair<uint32_t, PathId>, Slot> previous;
+    for (const Slot& slot : slots_) previous.emplace(std::make_pair(slot.rule, slot.device), slot);
+
+    slots_.clear();
+    first_.clear();
+    for (const auto& target : targets) {
+        first_.push_back(slots_.size());
+        if (rules_.empty()) continue;
+        PathId device = paths().intern(target.path);
+        for (uint32_t r = 0; r < rules_.size(); ++r) {
+            if (!rules_[r].matches(target.path)) continue;
+            auto kept = previous.find({r, device});
+            if (kept != previous.end()) {
+                slots_.push_back(kept->second);
+            } else {
+                Slot slot;
+                slot.rule = r;
+                slot.device = device;
+                slots_.push_back(slot);
+            }
+        }
+    }
+    first_.push_back(slots_.size());
+}
+
+void AlertEngine::insert(size_t item, const Binding& target) {
+    if (first_.empty()) first_.push_back(0);
+    if (item >= first_.size()) return;
+    size_t at = first_[item];
+    size_t added = 0;
+    if (!rules_.empty()) {
+        PathId device = paths().intern(target.path);
+        for (uint32_t r = 0; r < rules_.size(); ++r) {
+            if (!rules_[r].matches(target.path)) continue;
+            Slot slot;
+            slot.rule = r;
+            slot.device = device;
+            slots_.insert(slots_.begin() + static_cast<ptrdiff_t>(at + added++), slot);
+        }
+    }
+    first_.insert(first_.begin() + static_cast<ptrdiff_t>(item), at);
+    for (size_t i = item + 1; i < first_.size(); ++i) first_[i] += added;
+}
+
+void AlertEngine::erase(size_t item) {
+    if (item + 1 >= first_.size()) return;
+    size_t begin = first_[item];
+    size_t removed = first_[item + 1] - begin;
+    slots_.erase(slots_.begin() + static_cast<ptrdiff_t>(begin),
+                 slots_.begin() + static_cast<ptrdiff_t>(begin + removed));
+    first_.erase(first_.begin() + static_cast<ptrdiff_t>(item));
+    for (size_t i = item; i < first_.size(); ++i) first_[i] -= removed;
+}
+
+void AlertEngine::evaluate(size_t item, const Snapshot& snap) {
+    if (item + 1 >= first_.size()) return;
+    for (size_t k = first_[item]; k < first_[item + 1]; ++k) {
+        Slot& slot = slots_[k];
+        const AlertRule& rule = rules_[slot.rule];
+        int64_t value = 0;
+        if (!snap.number(rule.metric, value)) continue;
+
+        if (rule.rate) {
+            int64_t elapsed = snap.timestamp_ns - slot.last_ns;
+            bool ready = slot.primed && elapsed > 0;
+            int64_t previous = slot.last_value;
+            slot.primed = true;
+            slot.last_value = value;
+            slot.last_ns = snap.timestamp_ns;
+            if (!ready) continue;
+            value = static_cast<int64_t>(static_cast<double>(value - previous) * 1e9 / elapsed);
+        }
+
+        if (!slot.active) {
+            bool past = rule.above ? value > rule.threshold : value < rule.threshold;
+            slot.streak = past ? slot.streak + 1 : 0;
+            if (slot.streak < rule.hold) continue;
+            slot.active = true;
+        } else {
+            bool back = rule.above ? value < rule.clear : value > rule.clear;
+            if (!back) continue;
+            slot.active = false;
+            slot.streak = 0;
+        }
+        emit({slot.rule, slot.device, value, snap.timestamp_ns, slot.active});
+    }
+}
+
+void AlertEngine::emit(const AlertEvent& event) {
+    for (const Sink& sink : sinks_) {
+        sink.queue->push(event);
+        if (sink.notify) sink.notify();
+    }
+}
+
+std::string AlertEngine::describe(const AlertEvent& event) const {
+    if (event.rule >= rules_.size()) return "";
+    const AlertRule& rule = rules_[event.rule];
+    std::string text = rule.name + (event.raised ? ": " : " cleared: ");
+    text.append(paths().str(event.device)).append(" ").append(rule.metric);
+    text += " " + std::to_string(event.value) + (rule.rate ? "/s" : "");
+    if (event.raised) text += std::string(rule.above ? " > " : " < ") + std::to_string(rule.threshold);
+    return text;
+}
+
+// --- AlertHook ---
+
+AlertHook::AlertHook(std::string command, AlertEngine& engine)
+    : command_(std::move(command)), engine_(engine), wake_fd_(::eventfd(0, EFD_CLOEXEC)) {
+    engine.add_sink(&queue_, [this] {
+        uint64_t one = 1;
+        ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+        (void)n;
+    });
+    thread_ = std::thread(&AlertHook::run, this);
+}
+
+AlertHook::~AlertHook() {
+    stop_ = true;
+    uint64_t one = 1;
+    ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+    (void)n;
+    if (thread_.joinable()) thread_.join();
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+}
+
+void AlertHook::run() {
+    while (!stop_) {
+        uint64_t count = 0;
+        if (::read(wake_fd_, &count, sizeof(count)) < 0 && errno != EINTR) return;
+        AlertEvent event;
+        while (queue_.pop(event)) spawn(event);
+    }
+}
+
+void AlertHook::spawn(const AlertEvent& event) {
+    const AlertRule& rule = engine_.rules()[event.rule];
+    std::vector<std::string> vars = {
+        "KMAP_ALERT=" + rule.name,
+        "KMAP_DEVICE=" + std::string(paths().str(event.device)),
+        "KMAP_METRIC=" + std::string(rule.metric),
+        "KMAP_VALUE=" + std::to_string(event.value),
+        std::string("KMAP_STATE=") + (event.raised ? "raised" : "cleared"),
+    };
+    std::vector<char*> env;
+    for (char** e = environ; *e; ++e) env.push_back(*e);
+    for (auto& var : vars) env.push_back(var.data());
+    env.push_back(nullptr);
+
+    char sh[] = "/bin/sh";
+    char dash_c[] = "-c";
+    char* argv[] = {sh, dash_c, command_.data(), nullptr};
+    pid_t pid;
+    if (::posix_spawn(&pid, sh, nullptr, nullptr, argv, env.data()) != 0) return;
+    int status;
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+}
+
+std::string alert_rules_path(const std::string& option) {
+    if (!option.empty()) return option;
+    std::string base;
+    if (const char* xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        base = std::string(home) + "/.config";
+    } else {
+        return "";
+    }
+    std::string path = base + "/kmap/alerts";
+    return ::access(path.c_str(), R_OK) == 0 ? path : "";
+}
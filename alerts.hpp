@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bindings.hpp"
+#include "paths.hpp"
+#include "sensors.hpp"
+
+// One line of an alert rule file:
+//
+//   # name     device          metric      condition      options
+//   cpu-hot    thermal_zone*   temp        >  80000       clear=75000 for=3
+//   heating    *               temp        rate> 2000
+//   link-idle  eth0            rx_bytes/s  <  1000
+//
+// `device` is a glob matched against the device path, or against its last
+// component when it has no '/'. `metric` is a Snapshot number key and the
+// threshold is in its raw units; rate> and rate< compare the change per
+// second instead. An alert is raised after `for` consecutive samples past
+// the threshold (default 1) and cleared once the value is back past `clear`
+// (default the threshold itself), so a reading hovering at the limit
+// doesn't flap.
+struct AlertRule {
+    std::string name;
+    std::string pattern;
+    std::string_view metric;  // interned
+    bool above = true;        // > or rate>
+    bool rate = false;
+    int64_t threshold = 0;
+    int64_t clear = 0;
+    unsigned hold = 1;
+
+    bool matches(const std::string& device) const;
+};
+
+// A rule changing state on one device.
+struct AlertEvent {
+    uint32_t rule = 0;  // index into AlertEngine::rules()
+    PathId device = PathTable::kEmpty;
+    int64_t value = 0;  // the reading (or rate per second) that crossed
+    int64_t timestamp_ns = 0;
+    bool raised = false;  // false when it cleared
+};
+
+// Bounded multi-producer, single-consumer queue of AlertEvents: sampler
+// workers push without locks or allocation, and a full queue drops the
+// event (counted) rather than blocking a sampling pass.
+class AlertQueue {
+public:
+    static constexpr size_t kCapacity = 1024;  // power of two
+
+    AlertQueue();
+
+    bool push(const AlertEvent& event);
+    // Consumer side only.
+    bool pop(AlertEvent& out);
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        AlertEvent event;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> tail_{0};  // next push
+    alignas(64) std::atomic<size_t> head_{0};  // next pop
+    std::atomic<uint64_t> dropped_{0};
+};
+
+// Rules compiled from a file into a flat array, matched against the sampled
+// devices whenever the target list changes, and evaluated on the sampling
+// thread right after each device is sampled, in the TUI, headless and kmapd
+// alike. Transitions go to every sink queue; nothing is evaluated at render
+// time.
+class AlertEngine {
+public:
+    // Returns false with `error` set to "<path>:<line>: <problem>".
+    bool load(const std::string& path, std::string& error);
+
+    bool empty() const { return rules_.empty(); }
+    const std::vector<AlertRule>& rules() const { return rules_; }
+
+    // Whether any rule applies to the device.
+    bool watches(const std::string& device) const;
+
+    // Sinks are added before sampling starts. `notify`, if set, is called
+    // after pushing events to the queue, e.g. to wake its consumer.
+    void add_sink(AlertQueue* queue, std::function<void()> notify = nullptr);
+
+    // Matches the rules against a new target list. Must not overlap with
+    // evaluate(); per-device state carries over for devices still present.
+    void bind(const std::vector<Binding>& targets);
+    // The same for one target inserted at, or erased from, position `item`
+    // (later items shift), without rematching the rest.
+    void insert(size_t item, const Binding& target);
+    void erase(size_t item);
+
+    // Checks the rules bound to targets[item] against its fresh snapshot.
+    // Different items may be evaluated concurrently; one item never is.
+    void evaluate(size_t item, const Snapshot& snap);
+
+    // "cpu-hot: /sys/class/thermal/thermal_zone0 temp 82000 > 80000".
+    std::string describe(const AlertEvent& event) const;
+
+private:
+    struct Slot {
+        uint32_t rule = 0;
+        PathId device = PathTable::kEmpty;
+        bool active = false;
+        unsigned streak = 0;  // consecutive samples past the threshold
+        bool primed = false;  // rate rules: a previous reading exists
+        int64_t last_value = 0;
+        int64_t last_ns = 0;
+    };
+    struct Sink {
+        AlertQueue* queue;
+        std::function<void()> notify;
+    };
+
+    void emit(const AlertEvent& event);
+
+    std::vector<AlertRule> rules_;
+    std::vector<Sink> sinks_;
+    std::vector<Slot> slots_;     // grouped by item
+    std::vector<size_t> first_;   // item -> first slot, plus an end marker
+};
+
+// Runs a shell command for every alert event on a thread of its own, with
+// the event in its environment: KMAP_ALERT (rule name), KMAP_DEVICE,
+// KMAP_METRIC, KMAP_VALUE and KMAP_STATE ("raised" or "cleared"). Commands
+// run one at a time; events arriving meanwhile wait in the queue.
+class AlertHook {
+public:
+    AlertHook(std::string command, AlertEngine& engine);
+    ~AlertHook();
+
+    AlertHook(const AlertHook&) = delete;
+    AlertHook& operator=(const AlertHook&) = delete;
+
+private:
+    void run();
+    void spawn(const AlertEvent& event);
+
+    std::string command_;
+    const AlertEngine& engine_;
+    AlertQueue queue_;
+    int wake_fd_ = -1;  // eventfd
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+// --alerts when given, else $XDG_CONFIG_HOME/kmap/alerts (or
+// ~/.config/kmap/alerts) if it exists; empty when there's no rule file.
+std::string alert_rules_path(const std::string& option);
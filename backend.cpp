@@ -0,0 +1,280 @@
+#include "backend.hpp"
+
+#include "options.hpp"
+#include "rates.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::unique_ptr<AttrBackend>& installed() {
+    static std::unique_ptr<AttrBackend> backend = std::make_unique<SysfsBackend>();
+    return backend;
+}
+
+AttrBackend& attr_backend() {
+    return *installed();
+}
+
+void set_attr_backend(std::unique_ptr<AttrBackend> backend) {
+    installed() = std::move(backend);
+}
+
+bool host_sysfs() {
+    return attr_backend().host_path("/sys") == "/sys";
+}
+
+bool install_attr_backend(const Options& opts, std::string& error) {
+    if (opts.synthetic) {
+        SyntheticBackend::Spec spec;
+        if (!SyntheticBackend::parse_spec(opts.synthetic_spec, spec, error)) return false;
+        set_attr_backend(std::make_unique<SyntheticBackend>(spec));
+    } else if (!opts.sysfs_root.empty()) {
+        std::string root = opts.sysfs_root;
+        while (root.size() > 1 && root.back() == '/') root.pop_back();
+        struct stat st;
+        if (::stat(root.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            error = "not a directory: " + opts.sysfs_root;
+            return false;
+        }
+        set_attr_backend(std::make_unique<SysfsBackend>(root == "/sys" ? "" : root));
+    }
+    return true;
+}
+
+// --- SysfsBackend ---
+
+std::string SysfsBackend::host_path(const std::string& path) const {
+    // Only /sys moves; /proc and the rest are always the host's.
+    bool in_sys = path.compare(0, 4, "/sys") == 0 && (path.size() == 4 || path[4] == '/');
+    if (root_.empty() || !in_sys) return path;
+    return root_ + path.substr(4);
+}
+
+int SysfsBackend::open(const std::string& path) {
+    if (root_.empty()) return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    return ::open(host_path(path).c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+ssize_t SysfsBackend::pread(int handle, char* buf, size_t cap) {
+    return ::pread(handle, buf, cap, 0);
+}
+
+void SysfsBackend::close(int handle) {
+    ::close(handle);
+}
+
+bool SysfsBackend::exists(const std::string& path) const {
+    return ::access(host_path(path).c_str(), F_OK) == 0;
+}
+
+bool SysfsBackend::is_directory(const std::string& path) const {
+    struct stat st;
+    return ::stat(host_path(path).c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+std::vector<std::string> SysfsBackend::list(const std::string& dir) const {
+    std::vector<std::string> names;
+    DIR* d = ::opendir(host_path(dir).c_str());
+    if (!d) return names;
+    while (dirent* entry = ::readdir(d)) {
+        if (std::strcmp(entry->d_name, ".") == 0 || std::strcmp(entry->d_name, "..") == 0) continue;
+        names.emplace_back(entry->d_name);
+    }
+    ::closedir(d);
+    return names;
+}
+
+// --- SyntheticBackend ---
+
+static constexpr int64_t kGaugePeriodMs = 60000;
+static constexpr size_t kMaxSyntheticDevices = 1000000;
+
+static bool parse_count(const std::string& text, size_t& out) {
+    const char* last = text.data() + text.size();
+    auto result = std::from_chars(text.data(), last, out);
+    return result.ec == std::errc() && result.ptr == last && out <= kMaxSyntheticDevices;
+}
+
+bool SyntheticBackend::parse_spec(const std::string& text, Spec& out, std::string& error) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string part = text.substr(start, end - start);
+        start = end + 1;
+        if (part.empty()) continue;
+
+        size_t eq = part.find('=');
+        std::string key = part.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : part.substr(eq + 1);
+        bool ok = false;
+        if (key == "net") {
+            ok = parse_count(value, out.net);
+        } else if (key == "thermal") {
+            ok = parse_count(value, out.thermal);
+        } else if (key == "hwmon") {
+            // "20" chips, or "20x25" for 25 channels each.
+            size_t x = value.find('x');
+            ok = parse_count(value.substr(0, x), out.hwmon) &&
+                 (x == std::string::npos || (parse_count(value.substr(x + 1), out.hwmon_channels) &&
+                                             out.hwmon_channels > 0));
+        } else if (key == "churn") {
+            char* end_ptr = nullptr;
+            double percent = std::strtod(value.c_str(), &end_ptr);
+            std::string unit(end_ptr);
+            ok = end_ptr != value.c_str() && (unit.empty() || unit == "%") && percent >= 0 && percent <= 100;
+            out.churn = percent / 100;
+        } else {
+            error = "unknown synthetic device kind: " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "invalid synthetic spec: " + part;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Spreads the moving devices evenly over the index range, whatever the
+// share (the golden ratio's fractional multiples are equidistributed).
+static bool churns(size_t index, double churn) {
+    double position = static_cast<double>(index) * 0.6180339887498949;
+    return position - std::floor(position) < churn;
+}
+
+SyntheticBackend::SyntheticBackend(const Spec& spec) : start_ns_(monotonic_ns()) {
+    add_dir("/sys/class/net");
+    add_dir("/sys/class/thermal");
+    add_dir("/sys/class/hwmon");
+
+    static const char* const kCounters[] = {"rx_bytes", "tx_bytes", "rx_packets", "tx_packets", "rx_dropped",
+                                            "rx_errors"};
+    for (size_t i = 0; i < spec.net; ++i) {
+        std::string dev = "/sys/class/net/veth" + std::to_string(i);
+        bool moving = churns(i, spec.churn);
+        char mac[18];
+        std::snprintf(mac, sizeof(mac), "02:00:%02x:%02x:%02x:%02x", static_cast<unsigned>(i >> 24 & 0xff),
+                      static_cast<unsigned>(i >> 16 & 0xff), static_cast<unsigned>(i >> 8 & 0xff),
+                      static_cast<unsigned>(i & 0xff));
+        add_file(dev + "/operstate", {Kind::Text, i % 16 == 15 ? "down" : "up"});
+        add_file(dev + "/address", {Kind::Text, mac});
+        for (size_t c = 0; c < std::size(kCounters); ++c) {
+            // Bytes in the MB/s, packets in the kpkt/s; drops and errors rare.
+            int64_t rate = c < 2 ? 1000000 * static_cast<int64_t>(1 + (i * 7 + c) % 50)
+                         : c < 4 ? 1000 * static_cast<int64_t>(1 + (i * 3 + c) % 50)
+                                 : static_cast<int64_t>(i % 3);
+            add_file(dev + "/statistics/" + kCounters[c],
+                     {Kind::Counter, "", static_cast<int64_t>(i) * 1000003, moving ? rate : 0});
+        }
+    }
+
+    for (size_t i = 0; i < spec.thermal; ++i) {
+        std::string dev = "/sys/class/thermal/thermal_zone" + std::to_string(i);
+        add_file(dev + "/type", {Kind::Text, "synthetic" + std::to_string(i)});
+        add_file(dev + "/temp", {Kind::Gauge, "", 45000 + static_cast<int64_t>(i % 20) * 1000,
+                                 churns(i, spec.churn) ? 10000 : 0, static_cast<uint32_t>(i * 977 % kGaugePeriodMs)});
+        add_file(dev + "/trip_point_0_type", {Kind::Text, "critical"});
+        add_file(dev + "/trip_point_0_temp", {Kind::Text, "95000"});
+    }
+
+    for (size_t i = 0; i < spec.hwmon; ++i) {
+        std::string dev = "/sys/class/hwmon/hwmon" + std::to_string(i);
+        bool moving = churns(i, spec.churn);
+        add_file(dev + "/name", {Kind::Text, "synth" + std::to_string(i)});
+        for (size_t c = 1; c <= spec.hwmon_channels; ++c) {
+            std::string stem = dev + "/temp" + std::to_string(c);
+            add_file(stem + "_input", {Kind::Gauge, "", 40000 + static_cast<int64_t>(c % 10) * 2000,
+                                       moving ? 8000 : 0, static_cast<uint32_t>((i * 31 + c) * 613 % kGaugePeriodMs)});
+            add_file(stem + "_label", {Kind::Text, "Core " + std::to_string(c - 1)});
+        }
+    }
+}
+
+void SyntheticBackend::add_dir(const std::string& path) {
+    if (dirs_.count(path)) return;
+    dirs_.emplace(path, std::vector<std::string>{});
+    size_t slash = path.rfind('/');
+    if (slash == 0 || slash == std::string::npos) return;
+    std::string parent = path.substr(0, slash);
+    add_dir(parent);
+    dirs_[parent].push_back(path.substr(slash + 1));
+}
+
+void SyntheticBackend::add_file(const std::string& path, File file) {
+    size_t slash = path.rfind('/');
+    std::string parent = path.substr(0, slash);
+    add_dir(parent);
+    dirs_[parent].push_back(path.substr(slash + 1));
+    file_index_.emplace(path, static_cast<uint32_t>(files_.size()));
+    files_.push_back(std::move(file));
+}
+
+std::string SyntheticBackend::host_path(const std::string& path) const {
+    (void)path;
+    return "";
+}
+
+int SyntheticBackend::open(const std::string& path) {
+    auto it = file_index_.find(path);
+    if (it != file_index_.end()) return static_cast<int>(it->second);
+    errno = dirs_.count(path) ? EISDIR : ENOENT;
+    return -1;
+}
+
+ssize_t SyntheticBackend::pread(int handle, char* buf, size_t cap) {
+    if (handle < 0 || static_cast<size_t>(handle) >= files_.size()) {
+        errno = EBADF;
+        return -1;
+    }
+    const File& file = files_[handle];
+    char value[32];
+    const char* data = value;
+    size_t len = 0;
+    if (file.kind == Kind::Text) {
+        data = file.text.data();
+        len = file.text.size();
+    } else {
+        int64_t elapsed_ms = (monotonic_ns() - start_ns_) / 1000000;
+        int64_t number = file.base;
+        if (file.kind == Kind::Counter) {
+            number += file.rate * elapsed_ms / 1000;
+        } else if (file.rate) {
+            double turn = static_cast<double>((elapsed_ms + file.phase) % kGaugePeriodMs) / kGaugePeriodMs;
+            number += static_cast<int64_t>(file.rate * std::sin(turn * 2 * M_PI));
+        }
+        len = static_cast<size_t>(std::to_chars(value, value + sizeof(value), number).ptr - value);
+    }
+    // Sysfs values end in a newline.
+    size_t n = std::min(len, cap);
+    std::memcpy(buf, data, n);
+    if (n < cap) buf[n++] = '\n';
+    return static_cast<ssize_t>(n);
+}
+
+void SyntheticBackend::close(int handle) {
+    (void)handle;
+}
+
+bool SyntheticBackend::exists(const std::string& path) const {
+    return file_index_.count(path) || dirs_.count(path);
+}
+
+bool SyntheticBackend::is_directory(const std::string& path) const {
+    return dirs_.count(path) != 0;
+}
+
+std::vector<std::string> SyntheticBackend::list(const std::string& dir) const {
+    auto it = dirs_.find(dir);
+    return it == dirs_.end() ? std::vector<std::string>{} : it->second;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+struct Options;
+
+// Where device attributes come from. Listing a category, probing a device
+// and reading its attributes all go through the process's backend, always
+// by the path the UI shows ("/sys/class/net/eth0/operstate"); the backend
+// decides what is behind it:
+//   SysfsBackend      the files themselves, or those under another root
+//                     (--sysfs-root=<dir>: "/sys/class/net" is
+//                     <dir>/class/net), e.g. a copy of a big machine's /sys
+//   SyntheticBackend  an in-memory tree built from a spec (--synthetic),
+//                     with values that move over time, for device counts no
+//                     test machine has
+// The CPU driver's /proc/stat and /proc/cpuinfo go through it as well: a
+// SysfsBackend always reads the host's /proc, a SyntheticBackend has none,
+// so a synthetic tree lists no CPU.
+// Installed once at startup, before any thread reads attributes; every
+// method is thread-safe.
+class AttrBackend {
+public:
+    virtual ~AttrBackend() = default;
+
+    // The host file behind `path`, for what needs the real thing (the tree
+    // explorer, getdents64 listings); empty when there is none.
+    virtual std::string host_path(const std::string& path) const = 0;
+    // Whether handles are kernel fds, which io_uring can batch.
+    virtual bool kernel_fds() const = 0;
+
+    // A handle for pread() and close(), or -1 with errno set.
+    virtual int open(const std::string& path) = 0;
+    // From offset 0, like pread(2): bytes read, or -1 with errno set.
+    virtual ssize_t pread(int handle, char* buf, size_t cap) = 0;
+    virtual void close(int handle) = 0;
+
+    virtual bool exists(const std::string& path) const = 0;
+    virtual bool is_directory(const std::string& path) const = 0;
+    // Entry names of a directory, unsorted; empty if it doesn't exist.
+    virtual std::vector<std::string> list(const std::string& dir) const = 0;
+};
+
+AttrBackend& attr_backend();
+void set_attr_backend(std::unique_ptr<AttrBackend> backend);
+
+// True while the backend is the host's own /sys, the only tree uevents
+// describe.
+bool host_sysfs();
+
+// The backend --sysfs-root or --synthetic ask for, if any. False with
+// `error` set for a root that isn't a directory or a malformed spec.
+bool install_attr_backend(const Options& opts, std::string& error);
+
+class SysfsBackend : public AttrBackend {
+public:
+    // An empty root is /sys itself.
+    explicit SysfsBackend(std::string root = "") : root_(std::move(root)) {}
+
+    std::string host_path(const std::string& path) const override;
+    bool kernel_fds() const override { return true; }
+    int open(const std::string& path) override;
+    ssize_t pread(int handle, char* buf, size_t cap) override;
+    void close(int handle) override;
+    bool exists(const std::string& path) const override;
+    bool is_directory(const std::string& path) const override;
+    std::vector<std::string> list(const std::string& dir) const override;
+
+private:
+    std::string root_;
+};
+
+// Net interfaces (operstate, address and the statistics counters), thermal
+// zones and hwmon chips with temperature channels, laid out as sysfs does.
+// A `churn` share of the devices have moving values: counters climbing at a
+// per-device rate and temperatures drifting, both computed from the clock
+// when read; the rest stay constant, as most attributes of a big machine
+// do. Nothing is stored per read, so any number of sampler threads can read
+// at once.
+class SyntheticBackend : public AttrBackend {
+public:
+    struct Spec {
+        size_t net = 1000;
+        size_t thermal = 16;
+        size_t hwmon = 8;
+        size_t hwmon_channels = 8;
+        double churn = 0.2;
+    };
+
+    // "net=10000,thermal=50,hwmon=20x25,churn=30%"; missing keys keep the
+    // defaults above.
+    static bool parse_spec(const std::string& text, Spec& out, std::string& error);
+
+    explicit SyntheticBackend(const Spec& spec);
+
+    std::string host_path(const std::string& path) const override;
+    bool kernel_fds() const override { return false; }
+    int open(const std::string& path) override;
+    ssize_t pread(int handle, char* buf, size_t cap) override;
+    void close(int handle) override;
+    bool exists(const std::string& path) const override;
+    bool is_directory(const std::string& path) const override;
+    std::vector<std::string> list(const std::string& dir) const override;
+
+    size_t files() const { return files_.size(); }
+
+private:
+    enum class Kind : uint8_t { Text, Counter, Gauge };
+
+    struct File {
+        Kind kind = Kind::Text;
+        std::string text;   // Text
+        int64_t base = 0;   // Counter start, Gauge centre
+        int64_t rate = 0;   // Counter per second, Gauge amplitude; 0 holds still
+        uint32_t phase = 0;  // Gauge, in ms
+    };
+
+    void add_dir(const std::string& path);
+    void add_file(const std::string& path, File file);
+
+    std::vector<File> files_;
+    std::unordered_map<std::string, uint32_t> file_index_;
+    std::unordered_map<std::string, std::vector<std::string>> dirs_;
+    int64_t start_ns_ = 0;
+};
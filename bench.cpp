@@ -0,0 +1,191 @@
+// Microbenchmarks for the sysfs read strategies and for building the element
+// trees the UI renders. Run before and after a perf change:
+//   ./kmap_bench --benchmark_repetitions=5 --benchmark_report_aggregates_only
+
+#include <benchmark/benchmark.h>
+#include <ftxui/dom/elements.hpp>
+
+#include <string>
+#include <vector>
+
+#include "categories.hpp"
+#include "history.hpp"
+#include "rates.hpp"
+#include "sensors.hpp"
+#include "sysfs.hpp"
+
+namespace {
+
+struct Attribute {
+    std::string device;
+    std::string attr;
+};
+
+// Real attributes from /sys/class/thermal and /sys/class/net.
+const std::vector<Attribute>& attributes() {
+    static const std::vector<Attribute> attrs = [] {
+        std::vector<Attribute> out;
+        for (const auto& zone : list_devices("/sys/class/thermal")) {
+            if (zone.rfind("thermal_zone", 0) == 0) out.push_back({"/sys/class/thermal/" + zone, "temp"});
+        }
+        for (const auto& iface : list_devices("/sys/class/net")) {
+            for (const char* attr : {"statistics/rx_bytes", "statistics/tx_bytes", "statistics/rx_packets",
+                                     "statistics/tx_packets", "operstate"}) {
+                out.push_back({"/sys/class/net/" + iface, attr});
+            }
+        }
+        return out;
+    }();
+    return attrs;
+}
+
+void BM_ReadFileOneShot(benchmark::State& state) {
+    std::vector<std::string> paths;
+    for (const auto& a : attributes()) paths.push_back(a.device + "/" + a.attr);
+    if (paths.empty()) state.SkipWithError("no sysfs attributes found");
+
+    for (auto _ : state) {
+        for (const auto& path : paths) benchmark::DoNotOptimize(read_file(path));
+    }
+    state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_ReadFileOneShot);
+
+std::vector<SysfsReader::Handle> open_all(SysfsReader& io) {
+    std::vector<SysfsReader::Handle> handles;
+    for (const auto& a : attributes()) {
+        if (auto h = io.open(a.device, a.attr)) handles.push_back(h);
+    }
+    return handles;
+}
+
+void BM_ReadCachedPread(benchmark::State& state) {
+    SysfsReader io;
+    auto handles = open_all(io);
+    if (handles.empty()) state.SkipWithError("no sysfs attributes found");
+
+    // Without begin_pass() every read goes straight to pread().
+    char buf[256];
+    for (auto _ : state) {
+        for (auto h : handles) benchmark::DoNotOptimize(io.read(h, buf, sizeof(buf)));
+    }
+    state.SetItemsProcessed(state.iterations() * handles.size());
+}
+BENCHMARK(BM_ReadCachedPread);
+
+void BM_ReadUringBatch(benchmark::State& state) {
+    SysfsReader io;
+    auto handles = open_all(io);
+    if (handles.empty()) state.SkipWithError("no sysfs attributes found");
+    if (!io.batching()) state.SkipWithError("io_uring unavailable");
+
+    // One priming pass records the attribute set the next passes prefetch.
+    char buf[256];
+    io.begin_pass();
+    for (auto h : handles) io.read(h, buf, sizeof(buf));
+
+    for (auto _ : state) {
+        io.begin_pass();
+        for (auto h : handles) benchmark::DoNotOptimize(io.read(h, buf, sizeof(buf)));
+    }
+    state.SetItemsProcessed(state.iterations() * handles.size());
+}
+BENCHMARK(BM_ReadUringBatch);
+
+// What the sampler does: batched passes with per-attribute adaptive intervals.
+void BM_ReadAdaptive(benchmark::State& state) {
+    SysfsReader io;
+    io.set_adaptive(true);
+    auto handles = open_all(io);
+    if (handles.empty()) state.SkipWithError("no sysfs attributes found");
+
+    char buf[256];
+    size_t fresh = 0;
+    for (auto _ : state) {
+        io.begin_pass();
+        for (auto h : handles) {
+            benchmark::DoNotOptimize(io.read(h, buf, sizeof(buf)));
+            fresh += io.fresh();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * handles.size());
+    state.counters["fresh_ratio"] = static_cast<double>(fresh) / (state.iterations() * handles.size());
+}
+BENCHMARK(BM_ReadAdaptive);
+
+// N snapshots cloned from what the built-in drivers sample on this machine.
+struct Fixture {
+    std::vector<std::unique_ptr<Sensor>> drivers = make_default_drivers();
+    SysfsReader io;
+    HistoryStore history;
+    std::vector<Snapshot> samples;
+
+    Fixture() {
+        SampleContext ctx{io, history, monotonic_ns()};
+        for (const auto& category : default_categories()) {
+            for (const auto& device : category.list()) {
+                std::string path = category.root + "/" + device;
+                for (const auto& driver : drivers) {
+                    if (!driver->is_compatible(path)) continue;
+                    Snapshot snap;
+                    snap.path = path;
+                    snap.driver = driver.get();
+                    snap.timestamp_ns = ctx.now_ns;
+                    driver->sample(path, ctx, snap);
+                    samples.push_back(std::move(snap));
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<Snapshot> devices(size_t n) const {
+        std::vector<Snapshot> out;
+        if (samples.empty()) return out;
+        out.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            out.push_back(samples[i % samples.size()]);
+            out.back().path += "#" + std::to_string(i);
+        }
+        return out;
+    }
+};
+
+Fixture& fixture() {
+    static Fixture f;
+    return f;
+}
+
+void BM_RenderDetail(benchmark::State& state) {
+    auto devices = fixture().devices(static_cast<size_t>(state.range(0)));
+    if (devices.empty()) state.SkipWithError("no supported devices found");
+
+    for (auto _ : state) {
+        for (const auto& snap : devices) benchmark::DoNotOptimize(snap.driver->render(snap));
+    }
+    state.SetItemsProcessed(state.iterations() * devices.size());
+}
+BENCHMARK(BM_RenderDetail)->RangeMultiplier(8)->Range(1, 512);
+
+// Same shape as the overview grid in main.cpp.
+void BM_RenderOverview(benchmark::State& state) {
+    using namespace ftxui;
+    auto devices = fixture().devices(static_cast<size_t>(state.range(0)));
+    if (devices.empty()) state.SkipWithError("no supported devices found");
+
+    for (auto _ : state) {
+        Elements cards;
+        cards.reserve(devices.size());
+        for (const auto& snap : devices) {
+            std::string name = snap.path.substr(snap.path.rfind('/') + 1);
+            cards.push_back(window(text(" " + name + " "), snap.driver->summary(snap)) | size(WIDTH, EQUAL, 26));
+        }
+        benchmark::DoNotOptimize(hflow(cards));
+    }
+    state.SetItemsProcessed(state.iterations() * devices.size());
+}
+BENCHMARK(BM_RenderOverview)->RangeMultiplier(8)->Range(1, 512);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,70 @@
+#include "bindings.hpp"
+
+Binding bind_device(const std::string& root, std::string_view device,
+                    const std::vector<std::unique_ptr<Sensor>>& drivers) {
+    Binding binding;
+    binding.path.reserve(root.size() + 1 + device.size());
+    binding.path.append(root).append("/").append(device);
+    for (const auto& driver : drivers) {
+        if (driver->is_compatible(binding.path)) {
+            binding.driver = driver.get();
+            break;
+        }
+    }
+    return binding;
+}
+
+void BindingTable::rebuild(const std::string& root, const DeviceList& devices,
+                           const std::vector<std::unique_ptr<Sensor>>& drivers) {
+    root_ = root;
+    devices_ = &devices;
+    drivers_ = &drivers;
+    bindings_.assign(devices.size(), Binding{});
+    probed_.assign(devices.size(), false);
+}
+
+void BindingTable::insert(size_t index, const std::string& root, const std::string& device,
+                          const std::vector<std::unique_ptr<Sensor>>& drivers) {
+    if (index > bindings_.size()) index = bindings_.size();
+    bindings_.insert(bindings_.begin() + index, bind_device(root, device, drivers));
+    probed_.insert(probed_.begin() + index, true);
+}
+
+void BindingTable::erase(size_t index) {
+    if (index >= bindings_.size()) return;
+    bindings_.erase(bindings_.begin() + index);
+    probed_.erase(probed_.begin() + index);
+}
+
+void BindingTable::clear() {
+    bindings_.clear();
+    probed_.clear();
+    devices_ = nullptr;
+}
+
+void BindingTable::assign(std::vector<Binding> bindings) {
+    bindings_ = std::move(bindings);
+    probed_.assign(bindings_.size(), true);
+    devices_ = nullptr;
+}
+
+const Binding* BindingTable::at(int index) const {
+    if (index < 0 || static_cast<size_t>(index) >= bindings_.size()) return nullptr;
+    if (!probed_[index]) {
+        bindings_[index] = bind_device(root_, devices_->at(index), *drivers_);
+        probed_[index] = true;
+    }
+    return &bindings_[index];
+}
+
+std::vector<Binding> bind_categories(const std::vector<Category>& categories,
+                                     const std::vector<std::unique_ptr<Sensor>>& drivers) {
+    std::vector<Binding> targets;
+    for (const auto& category : categories) {
+        for (const auto& device : category.list()) {
+            Binding binding = bind_device(category.root, device, drivers);
+            if (binding.driver) targets.push_back(std::move(binding));
+        }
+    }
+    return targets;
+}
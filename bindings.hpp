@@ -0,0 +1,58 @@
+#pragma once
+
+#include "categories.hpp"
+#include "devlist.hpp"
+#include "sensors.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A device resolved to its full sysfs path and the driver that claimed it.
+struct Binding {
+    std::string path;
+    Sensor* driver = nullptr;
+
+    bool operator==(const Binding& other) const {
+        return driver == other.driver && path == other.path;
+    }
+    bool operator!=(const Binding& other) const { return !(*this == other); }
+};
+
+// root/device and the first driver claiming it (nullptr if none does).
+Binding bind_device(const std::string& root, std::string_view device,
+                    const std::vector<std::unique_ptr<Sensor>>& drivers);
+
+// Device index -> Binding. Kept index-aligned with the device list: callers
+// apply hotplug changes with insert()/erase() at the same index. After
+// rebuild(), a device's driver is probed the first time it is looked up, so
+// a category with thousands of entries only probes the ones shown or sampled.
+class BindingTable {
+public:
+    // `devices` must outlive the table or the next rebuild()/assign().
+    void rebuild(const std::string& root, const DeviceList& devices,
+                 const std::vector<std::unique_ptr<Sensor>>& drivers);
+    void insert(size_t index, const std::string& root, const std::string& device,
+                const std::vector<std::unique_ptr<Sensor>>& drivers);
+    void erase(size_t index);
+    void clear();
+
+    // Replaces the table with bindings resolved elsewhere (e.g. a remote daemon).
+    void assign(std::vector<Binding> bindings);
+
+    const Binding* at(int index) const;
+    size_t size() const { return bindings_.size(); }
+
+private:
+    // Lazily filled by at(); probed_ is index-aligned with bindings_.
+    mutable std::vector<Binding> bindings_;
+    mutable std::vector<bool> probed_;
+    std::string root_;
+    const DeviceList* devices_ = nullptr;
+    const std::vector<std::unique_ptr<Sensor>>* drivers_ = nullptr;
+};
+
+// Every device currently under the categories' roots that some driver claims.
+std::vector<Binding> bind_categories(const std::vector<Category>& categories,
+                                     const std::vector<std::unique_ptr<Sensor>>& drivers);
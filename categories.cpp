@@ -0,0 +1,53 @@
+#include "categories.hpp"
+
+#include "backend.hpp"
+
+#include <algorithm>
+
+std::vector<Category> default_categories() {
+    return {
+        {"thermal", "🔥 Thermals", "/sys/class/thermal",      ""},
+        {"hwmon",   "🌡  Hwmon",    "/sys/class/hwmon",        ""},
+        {"net",     "🌐 Network",  "/sys/class/net",          ""},
+        {"power",   "⚡ Power",    "/sys/class/power_supply", ""},
+        {"rapl",    "🔌 RAPL",     "/sys/class/powercap",     ""},
+        {"leds",    "💡 LEDs",     "/sys/class/leds",         ""},
+        {"cpu",     "🧮 CPU",      "/sys/devices/system",     "cpu"}
+    };
+}
+
+std::string Category::subsystem() const {
+    if (!device.empty()) return "";
+    size_t slash = root.rfind('/');
+    return slash == std::string::npos ? root : root.substr(slash + 1);
+}
+
+std::vector<std::string> list_devices(const std::string& root) {
+    std::vector<std::string> devices = attr_backend().list(root);
+    std::sort(devices.begin(), devices.end());
+    return devices;
+}
+
+std::vector<std::string> Category::list() const {
+    if (device.empty()) return list_devices(root);
+    if (!attr_backend().is_directory(root + "/" + device)) return {};
+    return {device};
+}
+
+bool select_categories(const std::vector<std::string>& ids, std::vector<Category>& out, std::string& unknown) {
+    std::vector<Category> all = default_categories();
+    for (const auto& id : ids) {
+        auto known = std::find_if(all.begin(), all.end(), [&](const Category& c) { return c.id == id; });
+        if (known == all.end()) {
+            unknown = id;
+            return false;
+        }
+    }
+    out.clear();
+    for (auto& category : all) {
+        if (ids.empty() || std::find(ids.begin(), ids.end(), category.id) != ids.end()) {
+            out.push_back(std::move(category));
+        }
+    }
+    return true;
+}
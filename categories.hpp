@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// A /sys/class subtree shown as one subsystem.
+struct Category {
+    std::string id;     // short name used on the command line, e.g. "net"
+    std::string label;  // menu label
+    std::string root;   // sysfs directory holding one entry per device
+    // When set, the category is this single entry of root rather than all
+    // of them, e.g. "cpu" under /sys/devices/system for the whole CPU.
+    std::string device = "";
+
+    // Kernel subsystem name reported in uevents, i.e. the last path
+    // component. Empty for single-device categories: their driver follows
+    // changes (CPUs going on- and offline) itself.
+    std::string subsystem() const;
+
+    // The category's devices: list_devices(root), or just `device` if it exists.
+    std::vector<std::string> list() const;
+};
+
+std::vector<Category> default_categories();
+
+// Sorted entry names under root; empty if the directory doesn't exist.
+std::vector<std::string> list_devices(const std::string& root);
+
+// The categories named by `ids` (all of them when empty), in default order.
+// Returns false with `unknown` set if an id doesn't exist.
+bool select_categories(const std::vector<std::string>& ids, std::vector<Category>& out, std::string& unknown);
@@ -0,0 +1,78 @@
+#include "cpustat.hpp"
+
+#include "backend.hpp"
+
+static inline bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+bool parse_cpu_times(std::string_view text, CpuTimes& all, std::vector<CpuTimes>& cores) {
+    all = CpuTimes{};
+    cores.clear();
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    while (end - p >= 3 && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        p += 3;
+        int cpu = -1;
+        if (p < end && is_digit(*p)) {
+            cpu = 0;
+            while (p < end && is_digit(*p)) cpu = cpu * 10 + (*p++ - '0');
+        }
+
+        // user nice system idle iowait irq softirq steal [guest guest_nice],
+        // the guest times already being part of user and nice.
+        uint64_t fields[8] = {};
+        int count = 0;
+        while (p < end && *p != '\n') {
+            if (*p == ' ') {
+                ++p;
+                continue;
+            }
+            uint64_t value = 0;
+            while (p < end && is_digit(*p)) value = value * 10 + static_cast<uint64_t>(*p++ - '0');
+            if (count < 8) fields[count] = value;
+            ++count;
+            while (p < end && *p != ' ' && *p != '\n') ++p;  // not a number: skip it
+        }
+        if (p == end) return false;  // cut off mid-line
+        ++p;
+
+        CpuTimes times;
+        times.cpu = cpu;
+        times.busy = fields[0] + fields[1] + fields[2] + fields[5] + fields[6] + fields[7];
+        times.total = times.busy + fields[3] + fields[4];
+        if (cpu < 0) {
+            all = times;
+        } else {
+            cores.push_back(times);
+        }
+    }
+    return p < end;
+}
+
+ProcStat::ProcStat(const char* path)
+    : backend_(attr_backend()),
+      fd_(backend_.open(path)),
+      buf_(std::make_unique<char[]>(kInitialBuffer)),
+      latency_(profiler().histogram("procstat")) {}
+
+ProcStat::~ProcStat() {
+    if (fd_ >= 0) backend_.close(fd_);
+}
+
+bool ProcStat::read(CpuTimes& all, std::vector<CpuTimes>& cores) {
+    if (fd_ < 0) return false;
+    for (;;) {
+        ssize_t n;
+        {
+            ScopedTimer timer(latency_);
+            n = backend_.pread(fd_, buf_.get(), cap_);
+        }
+        if (n <= 0) return false;
+        std::string_view text(buf_.get(), static_cast<size_t>(n));
+        if (parse_cpu_times(text, all, cores) || static_cast<size_t>(n) < cap_) return !cores.empty();
+        cap_ *= 2;
+        buf_ = std::make_unique<char[]>(cap_);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "profile.hpp"
+
+class AttrBackend;
+
+// Cumulative jiffies of one "cpu" line of /proc/stat.
+struct CpuTimes {
+    int cpu = -1;        // core number, -1 for the aggregate line
+    uint64_t busy = 0;   // user + nice + system + irq + softirq + steal
+    uint64_t total = 0;  // busy + idle + iowait
+};
+
+// Parses the "cpu" lines at the start of /proc/stat text into `all` and
+// `cores` (kept in file order: ascending online cores, gaps for offline
+// ones). A single forward pass with no sscanf/strtoull, since on a 256-core
+// machine this runs over ~2600 numbers per tick. Returns false if the text
+// ended inside the cpu section, i.e. the caller's buffer was too small.
+bool parse_cpu_times(std::string_view text, CpuTimes& all, std::vector<CpuTimes>& cores);
+
+// /proc/stat kept open through the attribute backend (backend.hpp) and
+// re-read with one pread() at offset 0 per call.
+// The kernel formats the whole file on every read, so the buffer is sized to
+// take it in one go: it starts at kInitialBuffer and doubles whenever the cpu
+// section didn't fit. Not thread-safe.
+class ProcStat {
+public:
+    static constexpr size_t kInitialBuffer = 16 * 1024;
+
+    explicit ProcStat(const char* path = "/proc/stat");
+    ~ProcStat();
+
+    ProcStat(const ProcStat&) = delete;
+    ProcStat& operator=(const ProcStat&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+
+    bool read(CpuTimes& all, std::vector<CpuTimes>& cores);
+
+private:
+    AttrBackend& backend_;
+    int fd_ = -1;
+    size_t cap_ = kInitialBuffer;
+    std::unique_ptr<char[]> buf_;
+    LatencyHistogram* latency_;
+};
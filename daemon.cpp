@@ -0,0 +1,265 @@
+#include "daemon.hpp"
+
+#include "alerts.hpp"
+#include "backend.hpp"
+#include "bindings.hpp"
+#include "categories.hpp"
+#include "history.hpp"
+#include "hotplug.hpp"
+#include "metrics.hpp"
+#include "profile.hpp"
+#include "rates.hpp"
+#include "sensors.hpp"
+#include "sockets.hpp"
+#include "sysfs.hpp"
+#include "wire.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void on_signal(int) {
+    g_stop = 1;
+}
+
+constexpr size_t kMaxBacklog = 4u << 20;
+
+struct Client {
+    int fd = -1;
+    std::string out;
+};
+
+// Sends as much of the backlog as the socket takes; false once it's dead.
+bool flush(Client& client) {
+    while (!client.out.empty()) {
+        ssize_t n = ::send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        client.out.erase(0, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+}  // namespace
+
+int run_daemon(const Options& opts) {
+    auto drivers = make_default_drivers();
+
+    std::vector<Category> categories;
+    std::string unknown;
+    if (!select_categories(opts.categories, categories, unknown)) {
+        std::fprintf(stderr, "kmapd: unknown category '%s'\n", unknown.c_str());
+        return 2;
+    }
+
+    std::string error;
+    AlertEngine alerts;
+    std::string rules = alert_rules_path(opts.alerts);
+    if (!rules.empty() && !alerts.load(rules, error)) {
+        std::fprintf(stderr, "kmapd: %s\n", error.c_str());
+        return 2;
+    }
+    // Transitions are logged; --alert-hook acts on them.
+    AlertQueue alert_events;
+    alerts.add_sink(&alert_events);
+    std::unique_ptr<AlertHook> hook;
+    if (!opts.alert_hook.empty()) hook = std::make_unique<AlertHook>(opts.alert_hook, alerts);
+
+    int listen_fd = listen_socket(opts.listen, error);
+    if (listen_fd < 0 || !set_nonblocking(listen_fd)) {
+        std::fprintf(stderr, "kmapd: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Each tick is published as a SnapshotSet for the metrics endpoint,
+    // copied into a pooled set so a steady tick doesn't allocate.
+    std::shared_ptr<const SnapshotSet> published;
+    std::vector<std::shared_ptr<SnapshotSet>> publish_pool;
+    std::unique_ptr<MetricsServer> metrics;
+    if (!opts.metrics_listen.empty()) {
+        metrics = std::make_unique<MetricsServer>(opts.metrics_listen, [&] { return std::atomic_load(&published); });
+        if (!metrics->ok()) {
+            std::fprintf(stderr, "kmapd: %s\n", metrics->error().c_str());
+            return 1;
+        }
+    }
+
+    HotplugMonitor hotplug(nullptr);
+    std::vector<Binding> targets = bind_categories(categories, drivers);
+    alerts.bind(targets);
+
+    SysfsReader io;
+    io.set_adaptive(true);
+    HistoryStore history;
+    SampleContext ctx{io, history};
+    std::vector<Snapshot> snaps;
+
+    DeltaEncoder encoder;
+    std::string frame;
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+
+    const int64_t interval_ns = static_cast<int64_t>(opts.interval.count()) * 1000000;
+    int64_t deadline = monotonic_ns();
+    CpuBudget budget(opts.max_cpu);
+
+    while (!g_stop) {
+        // A device that came is bound on its own and one that went is
+        // dropped, without relisting anything else; the encoder reports them
+        // to clients as added or removed.
+        for (const auto& event : hotplug.drain()) {
+            // Only the host's own /sys is what uevents describe.
+            if (!host_sysfs()) break;
+            for (const auto& category : categories) {
+                if (category.subsystem() != event.subsystem) continue;
+                std::string path = category.root + "/" + event.name;
+                auto it = std::find_if(targets.begin(), targets.end(),
+                                       [&](const Binding& b) { return b.path == path; });
+                if (event.action == HotplugEvent::Action::Add) {
+                    if (it != targets.end()) continue;
+                    Binding binding = bind_device(category.root, event.name, drivers);
+                    if (!binding.driver) continue;
+                    alerts.insert(targets.size(), binding);
+                    targets.push_back(std::move(binding));
+                } else {
+                    if (it == targets.end()) continue;
+                    io.forget(it->path);
+                    it->driver->forget(it->path);
+                    history.release(it->path);
+                    alerts.erase(static_cast<size_t>(it - targets.begin()));
+                    targets.erase(it);
+                }
+            }
+        }
+
+        ctx.now_ns = monotonic_ns();
+        io.begin_pass();
+        snaps.resize(targets.size());
+        for (size_t i = 0; i < targets.size(); ++i) {
+            Snapshot& snap = snaps[i];
+            snap.clear();
+            snap.path = targets[i].path;
+            snap.driver = targets[i].driver;
+            snap.timestamp_ns = ctx.now_ns;
+            snap.driver->sample(snap.path, ctx, snap);
+            alerts.evaluate(i, snap);
+        }
+        if (metrics) {
+            std::shared_ptr<SnapshotSet> set;
+            for (auto& pooled : publish_pool) {
+                if (pooled.use_count() == 1) {
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    set = pooled;
+                    break;
+                }
+            }
+            if (!set) {
+                set = std::make_shared<SnapshotSet>();
+                if (publish_pool.size() < 3) publish_pool.push_back(set);
+            }
+            set->devices = snaps;
+            uint64_t version = 14695981039346656037ull;
+            for (auto& snap : set->devices) {
+                snap.version = snap.digest();
+                version = (version ^ snap.version) * 1099511628211ull;
+            }
+            set->version = version;
+            std::atomic_store(&published, std::shared_ptr<const SnapshotSet>(std::move(set)));
+        }
+
+        AlertEvent event;
+        while (alert_events.pop(event)) std::fprintf(stderr, "kmapd: alert %s\n", alerts.describe(event).c_str());
+
+        // One frame per tick, shared by every client.
+        frame.clear();
+        encoder.encode(snaps, ctx.now_ns, frame);
+        for (auto& client : clients) {
+            if (client.fd < 0) continue;
+            client.out.append(frame);
+            if (client.out.size() > kMaxBacklog || !flush(client)) {
+                ::close(client.fd);
+                client.fd = -1;
+            }
+        }
+
+        deadline += budget.period(interval_ns);
+        int64_t now = monotonic_ns();
+        if (deadline < now) deadline = now;
+
+        // Serve connections until the next tick is due.
+        while (!g_stop && (now = monotonic_ns()) < deadline) {
+            clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.fd < 0; }),
+                          clients.end());
+            fds.clear();
+            fds.push_back({listen_fd, POLLIN, 0});
+            for (const auto& client : clients) {
+                fds.push_back({client.fd, static_cast<short>(POLLIN | (client.out.empty() ? 0 : POLLOUT)), 0});
+            }
+
+            int timeout_ms = static_cast<int>((deadline - now + 999999) / 1000000);
+            int ready = ::poll(fds.data(), fds.size(), timeout_ms);
+            if (ready <= 0) continue;
+
+            for (size_t i = 1; i < fds.size(); ++i) {
+                Client& client = clients[i - 1];
+                if (fds[i].revents & (POLLERR | POLLHUP)) {
+                    ::close(client.fd);
+                    client.fd = -1;
+                    continue;
+                }
+                if (fds[i].revents & POLLIN) {
+                    // Clients never send anything; readable means closed.
+                    char scratch[256];
+                    ssize_t n = ::recv(client.fd, scratch, sizeof(scratch), 0);
+                    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                        ::close(client.fd);
+                        client.fd = -1;
+                        continue;
+                    }
+                }
+                if ((fds[i].revents & POLLOUT) && !flush(client)) {
+                    ::close(client.fd);
+                    client.fd = -1;
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    Client client;
+                    client.fd = fd;
+                    client.out.assign(kWireMagic, kWireMagicSize);
+                    encoder.encode_full(ctx.now_ns, client.out);
+                    if (!flush(client)) {
+                        ::close(fd);
+                        continue;
+                    }
+                    clients.push_back(std::move(client));
+                }
+            }
+        }
+    }
+
+    for (auto& client : clients) {
+        if (client.fd >= 0) ::close(client.fd);
+    }
+    ::close(listen_fd);
+    return 0;
+}
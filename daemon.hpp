@@ -0,0 +1,9 @@
+#pragma once
+
+#include "options.hpp"
+
+// kmapd: samples the selected categories on a fixed interval and streams
+// delta frames (see wire.hpp) to every client connected to opts.listen.
+// A new client first gets the full current state. Clients that fall more
+// than a few MiB behind are dropped. Returns the process exit code.
+int run_daemon(const Options& opts);
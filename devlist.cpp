@@ -0,0 +1,260 @@
+#include "devlist.hpp"
+
+#include "backend.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace ftxui;
+
+// getdents64 has no glibc wrapper before 2.30.
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static constexpr size_t kDirentBuffer = 32 * 1024;
+
+DeviceList::~DeviceList() {
+    close();
+}
+
+void DeviceList::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    buf_len_ = buf_pos_ = 0;
+}
+
+bool DeviceList::open(const std::string& root) {
+    close();
+    sorted_.clear();
+    pending_.clear();
+    shown_.clear();
+    index_.clear();
+    arena_.clear();
+
+    const AttrBackend& backend = attr_backend();
+    std::string host = backend.host_path(root);
+    if (host.empty()) {
+        // No directory to stream: the backend lists it in memory, at once.
+        if (!backend.is_directory(root)) return false;
+        for (const auto& name : backend.list(root)) pending_.push_back(arena_.intern(name));
+        merge();
+        return true;
+    }
+    fd_ = ::open(host.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd_ < 0) return false;
+    if (!buf_) buf_ = std::make_unique<char[]>(kDirentBuffer);
+    return true;
+}
+
+bool DeviceList::step(size_t budget) {
+    while (fd_ >= 0 && pending_.size() < budget) {
+        if (buf_pos_ == buf_len_) {
+            long n = ::syscall(SYS_getdents64, fd_, buf_.get(), kDirentBuffer);
+            if (n <= 0) {
+                // End of directory, or it went away under us: keep what we have.
+                close();
+                break;
+            }
+            buf_len_ = static_cast<size_t>(n);
+            buf_pos_ = 0;
+        }
+        auto* d = reinterpret_cast<const LinuxDirent64*>(buf_.get() + buf_pos_);
+        buf_pos_ += d->d_reclen;
+        if (std::strcmp(d->d_name, ".") == 0 || std::strcmp(d->d_name, "..") == 0) continue;
+        pending_.push_back(arena_.intern(d->d_name));
+    }
+    merge();
+    return fd_ < 0;
+}
+
+void DeviceList::merge() {
+    if (pending_.empty()) return;
+    std::sort(pending_.begin(), pending_.end());
+    // Hotplug may have inserted some of these already.
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(),
+                                  [&](std::string_view name) { return find(name) != npos; }),
+                   pending_.end());
+    size_t middle = sorted_.size();
+    sorted_.insert(sorted_.end(), pending_.begin(), pending_.end());
+    std::inplace_merge(sorted_.begin(), sorted_.begin() + middle, sorted_.end());
+    for (std::string_view name : pending_) index_.add(name);
+    pending_.clear();
+    // Indices past the batch's first name all moved.
+    refilter();
+}
+
+void DeviceList::assign(const std::vector<std::string>& names) {
+    close();
+    sorted_.clear();
+    pending_.clear();
+    shown_.clear();
+    index_.clear();
+    arena_.clear();
+    for (const auto& name : names) pending_.push_back(arena_.intern(name));
+    merge();
+}
+
+size_t DeviceList::lower_bound(std::string_view name) const {
+    return std::lower_bound(sorted_.begin(), sorted_.end(), name) - sorted_.begin();
+}
+
+size_t DeviceList::find(std::string_view name) const {
+    size_t index = lower_bound(name);
+    return index < sorted_.size() && sorted_[index] == name ? index : npos;
+}
+
+size_t DeviceList::insert(std::string_view name) {
+    size_t index = lower_bound(name);
+    if (index < sorted_.size() && sorted_[index] == name) return npos;
+    std::string_view interned = arena_.intern(name);
+    sorted_.insert(sorted_.begin() + index, interned);
+    index_.add(interned);
+    if (filtered()) {
+        auto at = std::lower_bound(shown_.begin(), shown_.end(), index);
+        for (auto it = at; it != shown_.end(); ++it) ++*it;
+        if (filter_.matches(interned)) shown_.insert(at, static_cast<uint32_t>(index));
+    }
+    return index;
+}
+
+size_t DeviceList::erase(std::string_view name) {
+    size_t index = find(name);
+    if (index == npos) return npos;
+    index_.remove(sorted_[index]);
+    sorted_.erase(sorted_.begin() + index);
+    if (filtered()) {
+        auto at = std::lower_bound(shown_.begin(), shown_.end(), index);
+        if (at != shown_.end() && *at == index) at = shown_.erase(at);
+        for (auto it = at; it != shown_.end(); ++it) --*it;
+    }
+    return index;
+}
+
+void DeviceList::set_filter(std::string_view text) {
+    NameQuery next(text);
+    if (next.text() == filter_.text()) return;
+    bool narrowing = filtered() && !next.empty() && next.narrows(filter_);
+    filter_ = std::move(next);
+    if (!narrowing) {
+        refilter();
+        return;
+    }
+    shown_.erase(std::remove_if(shown_.begin(), shown_.end(),
+                                [&](uint32_t index) { return !filter_.matches(sorted_[index]); }),
+                 shown_.end());
+}
+
+void DeviceList::refilter() {
+    shown_.clear();
+    if (!filtered()) return;
+    index_.search(filter_, found_);
+    for (std::string_view name : found_) shown_.push_back(static_cast<uint32_t>(lower_bound(name)));
+    std::sort(shown_.begin(), shown_.end());
+}
+
+size_t DeviceList::row_of(size_t index) const {
+    if (!filtered()) return std::min(index, sorted_.size());
+    return std::lower_bound(shown_.begin(), shown_.end(), index) - shown_.begin();
+}
+
+namespace {
+
+class DeviceMenuBase : public ComponentBase {
+public:
+    DeviceMenuBase(const DeviceList* devices, int* selected, const std::string* placeholder)
+        : devices_(devices), selected_(selected), placeholder_(placeholder) {}
+
+    Element Render() override {
+        const int total = static_cast<int>(devices_->size());
+        if (total == 0) {
+            Element line = text(devices_->loading() ? "  (Loading...)" : "  " + *placeholder_);
+            return vbox({line}) | yflex | reflect(box_);
+        }
+        const int count = static_cast<int>(devices_->rows());
+        if (count == 0) return vbox({text("  (No matches)") | dim}) | yflex | reflect(box_);
+        // A selection the filter hides moves to the next shown row.
+        *selected_ = std::clamp(*selected_, 0, total - 1);
+        const int current = std::min(static_cast<int>(devices_->row_of(*selected_)), count - 1);
+        *selected_ = static_cast<int>(devices_->index_at(current));
+
+        // Height of the last frame; on the first one, rows past the bottom
+        // are simply clipped.
+        int rows = box_.y_max >= box_.y_min && box_.y_max > 0 ? box_.y_max - box_.y_min + 1 : 64;
+        bool status = count > rows || devices_->loading() || devices_->filtered();
+        page_ = std::max(1, rows - (status ? 1 : 0));
+
+        if (current < top_) top_ = current;
+        if (current >= top_ + page_) top_ = current - page_ + 1;
+        top_ = std::clamp(top_, 0, std::max(0, count - page_));
+
+        Elements lines;
+        bool focused = Focused();
+        int end = std::min(count, top_ + page_);
+        for (int i = top_; i < end; ++i) {
+            bool is_current = i == current;
+            std::string_view name = devices_->at(devices_->index_at(i));
+            std::string label = (is_current && focused ? "> " : "  ") + std::string(name);
+            Element line = text(std::move(label));
+            if (is_current) line = focused ? line | inverted | bold : line | bold;
+            lines.push_back(std::move(line));
+        }
+        if (status) {
+            lines.push_back(filler());
+            std::string where = std::to_string(current + 1) + "/" + std::to_string(count) +
+                                (devices_->filtered() ? " of " + std::to_string(total) : "") +
+                                (devices_->loading() ? "+ " : " ");
+            lines.push_back(text(where) | dim | align_right);
+        }
+        return vbox(std::move(lines)) | yflex | reflect(box_);
+    }
+
+    bool OnEvent(Event event) override {
+        const int count = static_cast<int>(devices_->rows());
+        if (count == 0) return false;
+        const int current = std::min(static_cast<int>(devices_->row_of(*selected_)), count - 1);
+        int next = current;
+        if (event == Event::ArrowUp) {
+            --next;
+        } else if (event == Event::ArrowDown) {
+            ++next;
+        } else if (event == Event::PageUp) {
+            next -= page_;
+        } else if (event == Event::PageDown) {
+            next += page_;
+        } else if (event == Event::Home) {
+            next = 0;
+        } else if (event == Event::End) {
+            next = count - 1;
+        } else {
+            return false;
+        }
+        next = std::clamp(next, 0, count - 1);
+        if (next == current) return false;  // lets the container move focus
+        *selected_ = static_cast<int>(devices_->index_at(next));
+        return true;
+    }
+
+    bool Focusable() const override { return true; }
+
+private:
+    const DeviceList* devices_;
+    int* selected_;
+    const std::string* placeholder_;
+    Box box_;
+    int top_ = 0;
+    int page_ = 1;
+};
+
+}  // namespace
+
+Component DeviceMenu(const DeviceList* devices, int* selected, const std::string* placeholder) {
+    return std::make_shared<DeviceMenuBase>(devices, selected, placeholder);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <ftxui/component/component.hpp>
+
+#include "filter.hpp"
+#include "paths.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// The sorted entries of one category directory. A directory is read in
+// getdents64 batches by step(), so a class with thousands of veth/macvlan
+// interfaces fills in over a few frames instead of blocking one; every batch
+// is sorted and merged in, and lookups are binary searches on the interned
+// names.
+//
+// A filter (the `/` prompt) narrows the rows shown without touching the
+// indices: rows are positions in the filtered view, indices positions in
+// the whole sorted list, which stays index-aligned with the bindings. The
+// names are kept in a TrigramIndex, updated with every insert and erase, so
+// neither a keystroke nor a uevent rescans or re-sorts the list; a
+// keystroke that only narrows the query filters the current rows.
+class DeviceList {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    DeviceList() = default;
+    ~DeviceList();
+
+    DeviceList(const DeviceList&) = delete;
+    DeviceList& operator=(const DeviceList&) = delete;
+
+    // Starts listing root; false (with an empty list) if it can't be opened.
+    // A backend without host directories (see backend.hpp) lists it whole.
+    bool open(const std::string& root);
+    // Reads and merges up to `budget` more entries. Returns true once the
+    // whole directory is in.
+    bool step(size_t budget);
+    bool loading() const { return fd_ >= 0; }
+
+    // Replaces the list with names known elsewhere (e.g. a remote source).
+    void assign(const std::vector<std::string>& names);
+
+    size_t size() const { return sorted_.size(); }
+    bool empty() const { return sorted_.empty(); }
+    std::string_view at(size_t index) const { return sorted_[index]; }
+
+    // First index whose name is not less than `name`.
+    size_t lower_bound(std::string_view name) const;
+    size_t find(std::string_view name) const;
+    // Both return the affected index, or npos if nothing changed.
+    size_t insert(std::string_view name);
+    size_t erase(std::string_view name);
+
+    // Kept across open() and assign(); an empty query shows every row.
+    void set_filter(std::string_view text);
+    const NameQuery& filter() const { return filter_; }
+    bool filtered() const { return !filter_.empty(); }
+
+    size_t rows() const { return filtered() ? shown_.size() : sorted_.size(); }
+    size_t index_at(size_t row) const { return filtered() ? shown_[row] : row; }
+    // The row showing `index`, else the first row after it (rows() if none).
+    size_t row_of(size_t index) const;
+
+private:
+    void close();
+    void merge();
+    void refilter();
+
+    NameArena arena_;
+    std::vector<std::string_view> sorted_;
+    std::vector<std::string_view> pending_;  // current batch, not yet merged
+    TrigramIndex index_;
+    NameQuery filter_;
+    std::vector<uint32_t> shown_;  // indices of the rows, ascending; when filtered()
+    std::vector<std::string_view> found_;  // refilter() scratch
+    int fd_ = -1;
+    std::unique_ptr<char[]> buf_;
+    size_t buf_len_ = 0;  // unread bytes of the last getdents64 call
+    size_t buf_pos_ = 0;
+};
+
+// Vertical menu over a DeviceList that only builds elements for the rows
+// that fit on screen, like ftxui::Menu otherwise (arrows, PageUp/PageDown,
+// Home/End). `placeholder` is shown instead when the list is empty.
+// `selected` is an index into the whole list; with a filter set, moving
+// only lands on shown rows.
+ftxui::Component DeviceMenu(const DeviceList* devices, int* selected, const std::string* placeholder);
@@ -0,0 +1,58 @@
+#include "discovery.hpp"
+
+#include "backend.hpp"
+#include "rates.hpp"
+
+#include <algorithm>
+
+Discovery::Discovery(std::vector<Category> categories, const std::vector<std::unique_ptr<Sensor>>& drivers,
+                     unsigned threads, std::function<void()> on_result)
+    : categories_(std::move(categories)),
+      drivers_(drivers),
+      on_result_(std::move(on_result)),
+      start_ns_(monotonic_ns()),
+      results_(categories_.size()),
+      ready_(std::make_unique<std::atomic<bool>[]>(categories_.size())),
+      remaining_(categories_.size()) {
+    if (threads == 0) {
+        threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), kMaxDefaultThreads);
+    }
+    threads = std::min<unsigned>(threads, static_cast<unsigned>(categories_.size()));
+    for (size_t i = 0; i < categories_.size(); ++i) ready_[i].store(false, std::memory_order_relaxed);
+    if (categories_.empty()) elapsed_ns_ = 1;
+    for (unsigned i = 0; i < threads; ++i) threads_.emplace_back(&Discovery::run, this);
+}
+
+Discovery::~Discovery() {
+    stop_ = true;
+    for (auto& thread : threads_) thread.join();
+}
+
+const Discovery::Result* Discovery::result(size_t category) const {
+    if (category >= results_.size() || !ready_[category].load(std::memory_order_acquire)) return nullptr;
+    return &results_[category];
+}
+
+void Discovery::run() {
+    while (!stop_) {
+        size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+        if (i >= categories_.size()) return;
+
+        const Category& category = categories_[i];
+        Result& result = results_[i];
+        int64_t start = monotonic_ns();
+        result.names = category.list();
+        result.bindings.reserve(result.names.size());
+        for (const auto& name : result.names) result.bindings.push_back(bind_device(category.root, name, drivers_));
+        result.missing = result.names.empty() &&
+                         (!category.device.empty() || !attr_backend().exists(category.root));
+        int64_t now = monotonic_ns();
+        result.elapsed_ns = now - start;
+
+        ready_[i].store(true, std::memory_order_release);
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            elapsed_ns_.store(std::max<int64_t>(now - start_ns_, 1), std::memory_order_release);
+        }
+        if (on_result_) on_result_();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "bindings.hpp"
+#include "categories.hpp"
+#include "sensors.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Lists and binds every category at startup on a few threads of its own, so
+// the UI can paint its first frame before any directory is read and pick
+// each category up as soon as its result lands, instead of walking them
+// one after another on the UI thread. A result is a snapshot from the
+// moment it was listed: callers apply later uevents themselves.
+class Discovery {
+public:
+    struct Result {
+        std::vector<std::string> names;  // sorted, as Category::list()
+        std::vector<Binding> bindings;   // index-aligned with names
+        bool missing = false;            // the category's root doesn't exist
+        int64_t elapsed_ns = 0;          // listing and probing this category
+    };
+
+    // threads == 0 picks one per core, up to kMaxDefaultThreads. `drivers`
+    // must outlive the discovery; `on_result` is called on a discovery
+    // thread after every published result.
+    Discovery(std::vector<Category> categories, const std::vector<std::unique_ptr<Sensor>>& drivers,
+              unsigned threads, std::function<void()> on_result);
+    ~Discovery();
+
+    Discovery(const Discovery&) = delete;
+    Discovery& operator=(const Discovery&) = delete;
+
+    // The category's result once it's in, else nullptr. Never changes once
+    // published.
+    const Result* result(size_t category) const;
+    bool done() const { return elapsed_ns() != 0; }
+
+    size_t threads() const { return threads_.size(); }
+    // Start to the last result; 0 until every category is in.
+    int64_t elapsed_ns() const { return elapsed_ns_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr unsigned kMaxDefaultThreads = 4;
+
+    void run();
+
+    std::vector<Category> categories_;
+    const std::vector<std::unique_ptr<Sensor>>& drivers_;
+    std::function<void()> on_result_;
+    int64_t start_ns_ = 0;
+
+    std::vector<Result> results_;
+    std::unique_ptr<std::atomic<bool>[]> ready_;
+    std::atomic<size_t> next_{0};
+    std::atomic<size_t> remaining_;
+    std::atomic<int64_t> elapsed_ns_{0};
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> threads_;
+};
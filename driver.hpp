@@ -0,0 +1,138 @@
+#pragma once
+
+#include <ftxui/dom/elements.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "history.hpp"
+#include "sysfs.hpp"
+
+// The interface every sensor driver implements, and the snapshot it fills.
+
+class Sensor;
+
+// Per-thread resources handed to Sensor::sample().
+struct SampleContext {
+    SysfsReader& io;
+    HistoryStore& history;
+    int64_t now_ns = 0;  // CLOCK_MONOTONIC stamp of this sampling pass
+};
+
+// One reading a driver exposes, described once at bind time.
+struct ChannelInfo {
+    std::string key;       // Snapshot number key, e.g. "temp1"
+    std::string label;     // e.g. "Package id 0", falls back to key
+    const char* unit = "";
+    int64_t divisor = 1;   // raw integer / divisor = value in `unit`
+    int64_t crit = 0;      // raw units, valid when has_crit
+    bool has_crit = false;
+};
+
+// Immutable per-device description built by a driver once and shared by
+// every Snapshot it produces, so labels and limits aren't re-read per tick.
+struct DeviceInfo {
+    std::string name;
+    std::vector<ChannelInfo> channels;
+};
+
+// Attribute values captured from one device by the sampler thread.
+//
+// Keys are never copied: they must be string literals or views from
+// paths(), which live as long as the process. Together with clear() keeping
+// every buffer (value strings included), refilling a snapshot of the same
+// shape allocates nothing.
+struct Snapshot {
+    std::string path;
+    Sensor* driver = nullptr;
+    std::shared_ptr<const DeviceInfo> info;
+    int64_t timestamp_ns = 0;
+    uint64_t version = 0;  // digest() at publish time
+    std::vector<std::pair<std::string_view, std::string>> values;
+    std::vector<std::pair<std::string_view, int64_t>> numbers;
+    std::vector<std::pair<std::string_view, const Series*>> history;
+
+    // Empties every field but keeps vector capacity for reuse.
+    void clear();
+
+    // Hash of the captured values; equal digests render identically.
+    uint64_t digest() const;
+
+    void set(std::string_view key, std::string_view value);
+    const std::string& get(std::string_view key) const;
+
+    void set_number(std::string_view key, int64_t value);
+    bool number(std::string_view key, int64_t& out) const;
+
+    void track(std::string_view key, const Series* series);
+    const Series* series(std::string_view key) const;
+
+private:
+    std::vector<std::string> spare_;  // value buffers kept by clear()
+};
+
+class Sensor {
+public:
+    virtual ~Sensor() = default;
+
+    // Short identifier used in profiling and output, e.g. "thermal".
+    virtual const char* name() const = 0;
+
+    virtual bool is_compatible(const std::string& path) = 0;
+
+    // Called on a sampler worker: this is the only place a driver touches
+    // sysfs. Different devices may be sampled concurrently, the same device
+    // never is.
+    virtual void sample(const std::string& path, SampleContext& ctx, Snapshot& snap) = 0;
+
+    // Called on the UI thread: formats an already captured snapshot.
+    virtual ftxui::Element render(const Snapshot& snap) = 0;
+
+    // One- or two-line form used by the category overview grid.
+    virtual ftxui::Element summary(const Snapshot& snap);
+
+    // Called between passes when a device is gone, so per-device state can
+    // be released.
+    virtual void forget(const std::string& path) { (void)path; }
+};
+
+// Per-device state a driver resolves once (attribute handles, series,
+// interned keys) and then reuses every tick. Handles belong to the reader
+// that opened them, so `resolve` runs again when the device is sampled
+// through another reader, e.g. after moving to another sampler worker; the
+// rest of the state (rate meters) carries over. States are map nodes, so
+// only finding one needs the lock: a device is sampled by one worker at a
+// time. State needs a `const SysfsReader* io` member.
+template <typename State>
+class DeviceStates {
+public:
+    template <typename Resolve>
+    State& get(const std::string& path, SampleContext& ctx, Resolve&& resolve) {
+        State* state;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = states_.find(path);
+            state = it != states_.end() ? &it->second : &states_[path];
+        }
+        if (state->io != &ctx.io) {
+            resolve(*state);
+            state->io = &ctx.io;
+        }
+        return *state;
+    }
+
+    void forget(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = states_.find(path);
+        if (it != states_.end()) states_.erase(it);
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, State, std::less<>> states_;
+};
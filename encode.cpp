@@ -0,0 +1,112 @@
+#include "encode.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static void append_json_string(std::string_view s, std::string& out) {
+    out.push_back('"');
+    for (char c : s) {
+        switch (c) {
+        case '"':  out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out.append(esc);
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+void encode_ndjson(const Snapshot& snap, std::string& out) {
+    char num[24];
+
+    out.append("{\"t\":");
+    std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(snap.timestamp_ns));
+    out.append(num);
+    out.append(",\"path\":");
+    append_json_string(snap.path, out);
+
+    out.append(",\"values\":{");
+    for (size_t i = 0; i < snap.values.size(); ++i) {
+        if (i) out.push_back(',');
+        append_json_string(snap.values[i].first, out);
+        out.push_back(':');
+        append_json_string(snap.values[i].second, out);
+    }
+
+    out.append("},\"numbers\":{");
+    for (size_t i = 0; i < snap.numbers.size(); ++i) {
+        if (i) out.push_back(',');
+        append_json_string(snap.numbers[i].first, out);
+        out.push_back(':');
+        std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(snap.numbers[i].second));
+        out.append(num);
+    }
+    out.append("}}\n");
+}
+
+void encode_alert_ndjson(const AlertEngine& engine, const AlertEvent& event, std::string& out) {
+    const AlertRule& rule = engine.rules()[event.rule];
+    char num[24];
+
+    out.append("{\"t\":");
+    std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(event.timestamp_ns));
+    out.append(num);
+    out.append(",\"alert\":");
+    append_json_string(rule.name, out);
+    out.append(",\"path\":");
+    append_json_string(paths().str(event.device), out);
+    out.append(",\"metric\":");
+    append_json_string(rule.metric, out);
+    out.append(",\"value\":");
+    std::snprintf(num, sizeof(num), "%lld", static_cast<long long>(event.value));
+    out.append(num);
+    out.append(event.raised ? ",\"state\":\"raised\"}\n" : ",\"state\":\"cleared\"}\n");
+}
+
+template <typename T>
+static void put(std::string& out, T value) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, &value, sizeof(T));
+    out.append(raw, sizeof(T));
+}
+
+static void put_str(std::string& out, std::string_view s) {
+    uint16_t len = s.size() > UINT16_MAX ? UINT16_MAX : static_cast<uint16_t>(s.size());
+    put<uint16_t>(out, len);
+    out.append(s.data(), len);
+}
+
+void encode_binary_header(std::string& out) {
+    out.append("KMAPBIN1", 8);
+}
+
+void encode_binary(const Snapshot& snap, std::string& out) {
+    size_t start = out.size();
+    put<uint32_t>(out, 0);  // patched below
+    put<int64_t>(out, snap.timestamp_ns);
+    put_str(out, snap.path);
+
+    put<uint16_t>(out, static_cast<uint16_t>(snap.values.size()));
+    for (const auto& kv : snap.values) {
+        put_str(out, kv.first);
+        put_str(out, kv.second);
+    }
+
+    put<uint16_t>(out, static_cast<uint16_t>(snap.numbers.size()));
+    for (const auto& kv : snap.numbers) {
+        put_str(out, kv.first);
+        put<int64_t>(out, kv.second);
+    }
+
+    uint32_t length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(&out[start], &length, sizeof(length));
+}
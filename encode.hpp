@@ -0,0 +1,27 @@
+#pragma once
+
+#include "alerts.hpp"
+#include "sensors.hpp"
+
+#include <string>
+
+// Serializers for headless output. Both append to `out` so a whole tick can
+// be batched into one buffer and flushed with a single write().
+
+// One JSON object per line:
+//   {"t":<monotonic ns>,"path":"...","values":{...},"numbers":{...}}
+void encode_ndjson(const Snapshot& snap, std::string& out);
+
+// An alert transition, on the same stream:
+//   {"t":<ns>,"alert":"<rule>","path":"...","metric":"...","value":<n>,"state":"raised"|"cleared"}
+void encode_alert_ndjson(const AlertEngine& engine, const AlertEvent& event, std::string& out);
+
+// Compact length-prefixed records in host byte order, after an 8-byte
+// "KMAPBIN1" stream header:
+//   u32 length of the rest of the record
+//   i64 timestamp_ns
+//   u16 path length, path bytes
+//   u16 string count, then per entry: u16 key len, key, u16 value len, value
+//   u16 number count, then per entry: u16 key len, key, i64 value
+void encode_binary_header(std::string& out);
+void encode_binary(const Snapshot& snap, std::string& out);
@@ -0,0 +1,126 @@
+#include "filter.hpp"
+
+#include <algorithm>
+
+static char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// `term` is already lowercase.
+static bool contains(std::string_view name, std::string_view term) {
+    if (term.size() > name.size()) return false;
+    for (size_t i = 0; i + term.size() <= name.size(); ++i) {
+        size_t j = 0;
+        while (j < term.size() && lower(name[i + j]) == term[j]) ++j;
+        if (j == term.size()) return true;
+    }
+    return false;
+}
+
+static bool by_address(std::string_view a, std::string_view b) {
+    return a.data() < b.data();
+}
+
+NameQuery::NameQuery(std::string_view text) : text_(text) {
+    std::string term;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') {
+            if (!term.empty()) terms_.push_back(std::move(term));
+            term.clear();
+        } else {
+            term.push_back(lower(c));
+        }
+    }
+    if (!term.empty()) terms_.push_back(std::move(term));
+}
+
+bool NameQuery::matches(std::string_view name) const {
+    for (const auto& term : terms_) {
+        if (!contains(name, term)) return false;
+    }
+    return true;
+}
+
+bool NameQuery::narrows(const NameQuery& wider) const {
+    for (const auto& term : wider.terms_) {
+        bool covered = std::any_of(terms_.begin(), terms_.end(), [&](const std::string& mine) {
+            return mine.find(term) != std::string::npos;
+        });
+        if (!covered) return false;
+    }
+    return true;
+}
+
+void TrigramIndex::trigrams(std::string_view s, std::vector<uint32_t>& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= s.size(); ++i) {
+        out.push_back(static_cast<uint32_t>(static_cast<unsigned char>(lower(s[i]))) << 16 |
+                      static_cast<uint32_t>(static_cast<unsigned char>(lower(s[i + 1]))) << 8 |
+                      static_cast<unsigned char>(lower(s[i + 2])));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void TrigramIndex::add(std::string_view name) {
+    auto at = std::lower_bound(names_.begin(), names_.end(), name, by_address);
+    if (at != names_.end() && at->data() == name.data()) return;
+    names_.insert(at, name);
+
+    trigrams(name, scratch_);
+    for (uint32_t t : scratch_) {
+        Postings& list = postings_[t];
+        list.insert(std::lower_bound(list.begin(), list.end(), name, by_address), name);
+    }
+}
+
+void TrigramIndex::remove(std::string_view name) {
+    auto at = std::lower_bound(names_.begin(), names_.end(), name, by_address);
+    if (at == names_.end() || at->data() != name.data()) return;
+    names_.erase(at);
+
+    trigrams(name, scratch_);
+    for (uint32_t t : scratch_) {
+        auto it = postings_.find(t);
+        if (it == postings_.end()) continue;
+        Postings& list = it->second;
+        auto entry = std::lower_bound(list.begin(), list.end(), name, by_address);
+        if (entry != list.end() && entry->data() == name.data()) list.erase(entry);
+        if (list.empty()) postings_.erase(it);
+    }
+}
+
+void TrigramIndex::clear() {
+    postings_.clear();
+    names_.clear();
+}
+
+void TrigramIndex::search(const NameQuery& query, std::vector<std::string_view>& out) const {
+    out.clear();
+    std::vector<uint32_t> wanted;
+    std::vector<uint32_t> term_trigrams;
+    for (const auto& term : query.terms()) {
+        trigrams(term, term_trigrams);
+        wanted.insert(wanted.end(), term_trigrams.begin(), term_trigrams.end());
+    }
+    std::sort(wanted.begin(), wanted.end());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+
+    // The shortest posting list bounds the result; the others are probed.
+    std::vector<const Postings*> lists;
+    for (uint32_t t : wanted) {
+        auto it = postings_.find(t);
+        if (it == postings_.end()) return;  // no name has this trigram
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const Postings* a, const Postings* b) { return a->size() < b->size(); });
+
+    const Postings& candidates = lists.empty() ? names_ : *lists.front();
+    for (std::string_view name : candidates) {
+        bool in_all = std::all_of(lists.begin() + (lists.empty() ? 0 : 1), lists.end(), [&](const Postings* list) {
+            return std::binary_search(list->begin(), list->end(), name, by_address);
+        });
+        // Trigrams only say the pieces are there; the terms must be whole.
+        if (in_all && query.matches(name)) out.push_back(name);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// What was typed after `/`: whitespace-separated terms, each of which must
+// occur somewhere in a name, ignoring ASCII case. "129 np1" matches
+// "enp129s0f1np1".
+class NameQuery {
+public:
+    NameQuery() = default;
+    explicit NameQuery(std::string_view text);
+
+    bool empty() const { return terms_.empty(); }
+    const std::string& text() const { return text_; }
+    const std::vector<std::string>& terms() const { return terms_; }  // lowercased
+
+    bool matches(std::string_view name) const;
+    // True if everything this matches is matched by `wider` too (it only
+    // adds terms or lengthens them), so a result for `wider` can be
+    // narrowed down instead of searched again.
+    bool narrows(const NameQuery& wider) const;
+
+private:
+    std::string text_;
+    std::vector<std::string> terms_;
+};
+
+// Trigram index over names that outlive it (NameArena views, for one):
+// every lowercase three-character window of a name maps to the names that
+// contain it, sorted by address. A query's candidates are the intersection
+// of the posting lists of its terms' trigrams, so a keystroke touches the
+// few names sharing its rarest trigram instead of every name. Terms shorter
+// than three characters have no trigrams of their own; a query of only
+// those checks every name. Adding or removing a name costs its own length
+// in posting updates. Not thread-safe.
+class TrigramIndex {
+public:
+    void add(std::string_view name);
+    void remove(std::string_view name);
+    void clear();
+
+    size_t size() const { return names_.size(); }
+
+    // Names matching `query`, in no particular order, into `out` (cleared).
+    void search(const NameQuery& query, std::vector<std::string_view>& out) const;
+
+private:
+    using Postings = std::vector<std::string_view>;  // sorted by data()
+
+    static void trigrams(std::string_view s, std::vector<uint32_t>& out);
+
+    std::unordered_map<uint32_t, Postings> postings_;
+    Postings names_;
+    std::vector<uint32_t> scratch_;
+};
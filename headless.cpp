@@ -0,0 +1,173 @@
+#include "headless.hpp"
+
+#include "alerts.hpp"
+#include "bindings.hpp"
+#include "categories.hpp"
+#include "encode.hpp"
+#include "history.hpp"
+#include "recording.hpp"
+#include "rates.hpp"
+#include "sensors.hpp"
+#include "sysfs.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void on_signal(int) {
+    g_stop = 1;
+}
+
+static bool write_all(int fd, const std::string& buf) {
+    const char* p = buf.data();
+    size_t left = buf.size();
+    while (left > 0) {
+        ssize_t n = ::write(fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void sleep_until(int64_t deadline_ns) {
+    timespec ts;
+    ts.tv_sec = deadline_ns / 1000000000;
+    ts.tv_nsec = deadline_ns % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        if (g_stop) return;
+    }
+}
+
+int run_headless(const Options& opts) {
+    auto drivers = make_default_drivers();
+
+    // Resolve every device of the requested categories once up front.
+    std::vector<Category> categories;
+    std::string unknown;
+    if (!select_categories(opts.categories, categories, unknown)) {
+        std::fprintf(stderr, "kmap: unknown category '%s'\n", unknown.c_str());
+        return 2;
+    }
+    std::vector<Binding> targets = bind_categories(categories, drivers);
+
+    // Alert transitions go into the ndjson stream next to the samples, and
+    // to stderr for the other outputs.
+    AlertEngine alerts;
+    std::string error;
+    std::string rules = alert_rules_path(opts.alerts);
+    if (!rules.empty() && !alerts.load(rules, error)) {
+        std::fprintf(stderr, "kmap: %s\n", error.c_str());
+        return 2;
+    }
+    AlertQueue alert_events;
+    alerts.add_sink(&alert_events);
+    std::unique_ptr<AlertHook> hook;
+    if (!opts.alert_hook.empty()) hook = std::make_unique<AlertHook>(opts.alert_hook, alerts);
+    alerts.bind(targets);
+    const bool alerts_inline = opts.record.empty() && opts.format == OutputFormat::Ndjson;
+
+    const int64_t interval_ns = static_cast<int64_t>(opts.interval.count()) * 1000000;
+
+    // --record writes a recording file instead of a stream.
+    std::unique_ptr<Recorder> recorder;
+    if (!opts.record.empty()) {
+        recorder = std::make_unique<Recorder>(opts.record, static_cast<uint64_t>(opts.record_size_mb) << 20,
+                                              interval_ns);
+        if (!recorder->ok()) {
+            std::fprintf(stderr, "kmap: %s\n", recorder->error().c_str());
+            return 1;
+        }
+    }
+
+    int fd = STDOUT_FILENO;
+    if (!recorder && !opts.output.empty()) {
+        fd = ::open(opts.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::fprintf(stderr, "kmap: %s: %s\n", opts.output.c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    SysfsReader io;
+    HistoryStore history;
+    SampleContext ctx{io, history};
+    Snapshot single;
+    std::vector<Snapshot> snaps(recorder ? targets.size() : 0);
+
+    // All records of a tick are batched here and flushed with one write().
+    std::string buf;
+    buf.reserve(1 << 20);
+    if (opts.format == OutputFormat::Binary) encode_binary_header(buf);
+
+    int64_t deadline = monotonic_ns();
+    int status = 0;
+
+    for (long tick = 0; !g_stop && (opts.samples == 0 || tick < opts.samples); ++tick) {
+        ctx.now_ns = monotonic_ns();
+        io.begin_pass();
+        for (size_t i = 0; i < targets.size(); ++i) {
+            const Binding& target = targets[i];
+            Snapshot& snap = recorder ? snaps[i] : single;
+            snap.clear();
+            snap.path = target.path;
+            snap.driver = target.driver;
+            snap.timestamp_ns = ctx.now_ns;
+            target.driver->sample(target.path, ctx, snap);
+            alerts.evaluate(i, snap);
+            if (recorder) continue;
+
+            if (opts.format == OutputFormat::Binary) {
+                encode_binary(snap, buf);
+            } else {
+                encode_ndjson(snap, buf);
+            }
+        }
+
+        AlertEvent event;
+        while (alert_events.pop(event)) {
+            if (alerts_inline) {
+                encode_alert_ndjson(alerts, event, buf);
+            } else {
+                std::fprintf(stderr, "kmap: alert %s\n", alerts.describe(event).c_str());
+            }
+        }
+
+        if (recorder) {
+            if (!recorder->append(snaps, ctx.now_ns)) {
+                std::fprintf(stderr, "kmap: %s is full; recording stopped\n", opts.record.c_str());
+                break;
+            }
+        } else if (!write_all(fd, buf)) {
+            if (errno != EPIPE) std::fprintf(stderr, "kmap: write: %s\n", std::strerror(errno));
+            status = errno == EPIPE ? 0 : 1;
+            break;
+        }
+        buf.clear();
+
+        if (opts.samples && tick + 1 == opts.samples) break;
+
+        // Fixed-rate schedule; if a tick overran, resync instead of bursting.
+        deadline += interval_ns;
+        int64_t now = monotonic_ns();
+        if (deadline < now) deadline = now;
+        sleep_until(deadline);
+    }
+
+    if (fd != STDOUT_FILENO) ::close(fd);
+    return status;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "options.hpp"
+
+// Samples the selected categories on a fixed interval and streams every
+// device's Snapshot to stdout or a file, without touching the terminal.
+// With opts.record set, ticks go into a recording file instead.
+// Returns the process exit code.
+int run_headless(const Options& opts);
@@ -0,0 +1,46 @@
+#include "history.hpp"
+
+#include <cstdio>
+
+HistoryStore::HistoryStore(size_t max_series)
+    : slots_(new Series[max_series]), capacity_(max_series) {}
+
+Series* HistoryStore::series(const std::string& device, std::string_view metric) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto dev = index_.find(device);
+    if (dev == index_.end()) dev = index_.emplace(device, MetricMap{}).first;
+
+    auto it = dev->second.find(metric);
+    if (it != dev->second.end()) return it->second;
+
+    Series* slot = nullptr;
+    if (!free_.empty()) {
+        slot = free_.back();
+        free_.pop_back();
+        slot->reset();
+    } else if (next_ < capacity_) {
+        slot = &slots_[next_++];
+    } else {
+        if (!reported_full_) {
+            reported_full_ = true;
+            std::fprintf(stderr, "kmap: history full (%zu series); new devices are not graphed\n", capacity_);
+        }
+        if (dev->second.empty()) index_.erase(dev);
+        return nullptr;
+    }
+    dev->second.emplace(std::string(metric), slot);
+    return slot;
+}
+
+void HistoryStore::release(const std::string& device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto dev = index_.find(device);
+    if (dev == index_.end()) return;
+    for (const auto& kv : dev->second) free_.push_back(kv.second);
+    index_.erase(dev);
+}
+
+size_t HistoryStore::used() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_ - free_.size();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-capacity history of one metric. Single producer (the sampler) and
+// single consumer (the renderer); neither side locks or allocates. When the
+// writer laps a slow reader, the reader may see the oldest slot already
+// overwritten, which is harmless for a graph.
+class Series {
+public:
+    static constexpr size_t kCapacity = 128;
+
+    // Producer side.
+    void push(int64_t value) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        values_[head % kCapacity].store(value, std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Consumer side: copies up to n of the newest values, oldest first, and
+    // returns how many were copied.
+    size_t copy_latest(int64_t* out, size_t n) const {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        size_t count = n;
+        if (count > kCapacity) count = kCapacity;
+        if (count > head) count = static_cast<size_t>(head);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = values_[(head - count + i) % kCapacity].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    uint64_t total() const { return head_.load(std::memory_order_acquire); }
+
+    // Empties it for a new producer, once the old one is gone.
+    void reset() { head_.store(0, std::memory_order_release); }
+
+private:
+    std::array<std::atomic<int64_t>, kCapacity> values_{};
+    std::atomic<uint64_t> head_{0};
+};
+
+// Preallocated pool of Series keyed by (device path, metric). All slots are
+// allocated up front and never move, so Series pointers handed out here stay
+// valid for the store's lifetime. Lookups lock, since every sampler worker
+// shares one store; the renderer reaches a Series through the pointer
+// carried in a Snapshot.
+//
+// A device that goes away gives its slots back with release(), so hotplug
+// churn (veths, USB NICs) doesn't exhaust the pool. A released slot is
+// handed to the next new metric; a snapshot published before the release
+// may briefly graph the new owner's values, which is harmless.
+class HistoryStore {
+public:
+    explicit HistoryStore(size_t max_series = 1024);
+
+    // Returns nullptr once every slot is taken; the first time, says so on
+    // stderr.
+    Series* series(const std::string& device, std::string_view metric);
+    // Frees every slot held for `device`. Its producer must be done with them.
+    void release(const std::string& device);
+
+    size_t used() const;
+    size_t capacity() const { return capacity_; }
+
+private:
+    using MetricMap = std::map<std::string, Series*, std::less<>>;
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<Series[]> slots_;
+    size_t capacity_;
+    size_t next_ = 0;           // slots never handed out start here
+    std::vector<Series*> free_;  // released slots
+    bool reported_full_ = false;
+    std::map<std::string, MetricMap, std::less<>> index_;
+};
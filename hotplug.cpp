@@ -0,0 +1,100 @@
+#include "hotplug.hpp"
+
+#include <cstring>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <string_view>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static std::string_view basename_of(std::string_view path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+HotplugMonitor::HotplugMonitor(std::function<void()> on_event)
+    : on_event_(std::move(on_event)) {
+    sock_ = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (sock_ < 0) return;
+
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = 1;  // kernel uevents, not the udevd rebroadcast
+    if (::bind(sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(sock_);
+        sock_ = -1;
+        return;
+    }
+
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC);
+    thread_ = std::thread(&HotplugMonitor::run, this);
+}
+
+HotplugMonitor::~HotplugMonitor() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        (void)::write(wake_fd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (sock_ >= 0) ::close(sock_);
+}
+
+std::vector<HotplugEvent> HotplugMonitor::drain() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<HotplugEvent> events;
+    events.swap(pending_);
+    return events;
+}
+
+void HotplugMonitor::run() {
+    char buf[8192];
+    pollfd fds[2] = {{sock_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+
+    while (true) {
+        if (::poll(fds, 2, -1) < 0) continue;
+        if (fds[1].revents) return;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        ssize_t n = ::recv(sock_, buf, sizeof(buf), 0);
+        if (n > 0) parse(buf, static_cast<size_t>(n));
+    }
+}
+
+// A kernel uevent is "action@devpath\0KEY=value\0KEY=value\0...".
+void HotplugMonitor::parse(const char* msg, size_t len) {
+    std::string_view action, devpath, devpath_old, subsystem;
+    size_t pos = std::strlen(msg) + 1;
+    while (pos < len) {
+        std::string_view field(msg + pos, ::strnlen(msg + pos, len - pos));
+        pos += field.size() + 1;
+        if (field.rfind("ACTION=", 0) == 0) action = field.substr(7);
+        else if (field.rfind("DEVPATH=", 0) == 0) devpath = field.substr(8);
+        else if (field.rfind("DEVPATH_OLD=", 0) == 0) devpath_old = field.substr(12);
+        else if (field.rfind("SUBSYSTEM=", 0) == 0) subsystem = field.substr(10);
+    }
+    if (devpath.empty() || subsystem.empty()) return;
+
+    std::vector<HotplugEvent> events;
+    auto emit = [&](HotplugEvent::Action a, std::string_view path) {
+        events.push_back({a, std::string(subsystem), std::string(basename_of(path))});
+    };
+    if (action == "add") {
+        emit(HotplugEvent::Action::Add, devpath);
+    } else if (action == "remove") {
+        emit(HotplugEvent::Action::Remove, devpath);
+    } else if (action == "move" && !devpath_old.empty()) {
+        // Renames (e.g. eth0 -> enp3s0) arrive as a single move.
+        emit(HotplugEvent::Action::Remove, devpath_old);
+        emit(HotplugEvent::Action::Add, devpath);
+    } else {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& e : events) pending_.push_back(std::move(e));
+    }
+    if (on_event_) on_event_();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A device appearing in or leaving a /sys/class/<subsystem> directory.
+struct HotplugEvent {
+    enum class Action { Add, Remove };
+
+    Action action;
+    std::string subsystem;  // e.g. "net", "power_supply"
+    std::string name;       // entry name under /sys/class/<subsystem>
+};
+
+// Listens for kernel uevents on a NETLINK_KOBJECT_UEVENT socket on its own
+// thread and queues add/remove events for the UI thread to apply. If the
+// socket can't be opened (e.g. a restricted container), available() is
+// false and the device list simply stays static.
+class HotplugMonitor {
+public:
+    explicit HotplugMonitor(std::function<void()> on_event);
+    ~HotplugMonitor();
+
+    HotplugMonitor(const HotplugMonitor&) = delete;
+    HotplugMonitor& operator=(const HotplugMonitor&) = delete;
+
+    bool available() const { return sock_ >= 0; }
+
+    // Takes every event queued since the last call.
+    std::vector<HotplugEvent> drain();
+
+private:
+    void run();
+    void parse(const char* msg, size_t len);
+
+    std::function<void()> on_event_;
+    int sock_ = -1;
+    int wake_fd_ = -1;
+
+    std::mutex mutex_;
+    std::vector<HotplugEvent> pending_;
+    std::thread thread_;
+};
@@ -0,0 +1,24 @@
+#include <cstdio>
+#include <string>
+
+#include "backend.hpp"
+#include "daemon.hpp"
+#include "options.hpp"
+
+int main(int argc, char** argv) {
+    Options opts;
+    std::string error;
+    if (!parse_options(argc, argv, opts, error)) {
+        std::fprintf(stderr, "kmapd: %s\n%s", error.c_str(), usage());
+        return 2;
+    }
+    if (opts.help) {
+        std::fputs(usage(), stdout);
+        return 0;
+    }
+    if (!install_attr_backend(opts, error)) {
+        std::fprintf(stderr, "kmapd: %s\n", error.c_str());
+        return 2;
+    }
+    return run_daemon(opts);
+}
@@ -1,200 +1,815 @@
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
-#include <filesystem>
-#include <fstream>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdio>
+#include <map>
 #include <memory> // Required for std::unique_ptr
+#include <string_view>
+#include <unordered_set>
+#include <unistd.h>
+
+#include "alerts.hpp"
+#include "backend.hpp"
+#include "bindings.hpp"
+#include "categories.hpp"
+#include "devlist.hpp"
+#include "discovery.hpp"
+#include "headless.hpp"
+#include "hotplug.hpp"
+#include "metrics.hpp"
+#include "options.hpp"
+#include "profile.hpp"
+#include "rack.hpp"
+#include "rates.hpp"
+#include "redraw.hpp"
+#include "remote.hpp"
+#include "replay.hpp"
+#include "sampler.hpp"
+#include "sensors.hpp"
+#include "tree.hpp"
+#include "units.hpp"
 
 using namespace ftxui;
-namespace fs = std::filesystem;
-
-std::string read_file(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) return "";
-    std::string line;
-    std::getline(file, line);
-    return line;
-}
-
-class Sensor {
-public:
-    virtual ~Sensor() = default;
-    
-    virtual bool is_compatible(const std::string& path) = 0;
-    
-    virtual Element render(const std::string& path) = 0;
-};
-
-class ThermalSensor : public Sensor {
-public:
-    bool is_compatible(const std::string& path) override {
-        // We claim this device if it has a 'temp' file
-        return fs::exists(path + "/temp");
-    }
 
-    Element render(const std::string& path) override {
-        std::string raw = read_file(path + "/temp");
-        if (raw.empty()) return text("Error reading temp");
-
-        try {
-            float temp = std::stof(raw) / 1000.0f;
-            
-            // Build the UI component
-            auto content = hbox({
-                text("Temperature: ") | bold,
-                text(std::to_string(temp).substr(0, 4) + " °C") 
-                    | color(temp > 60 ? Color::Red : Color::Green)
-            });
-
-            // Add sensor type if available
-            std::string type = read_file(path + "/type");
-            if (!type.empty()) {
-                return vbox({ content, text("Sensor Type: " + type) });
-            }
-            return content;
-        } catch (...) {
-            return text("Parse Error");
-        }
+int main(int argc, char** argv) {
+    const int64_t start_ns = monotonic_ns();
+    Options opts;
+    std::string error;
+    if (!parse_options(argc, argv, opts, error)) {
+        std::fprintf(stderr, "kmap: %s\n%s", error.c_str(), usage());
+        return 2;
+    }
+    if (opts.help) {
+        std::fputs(usage(), stdout);
+        return 0;
+    }
+    if (!install_attr_backend(opts, error)) {
+        std::fprintf(stderr, "kmap: %s\n", error.c_str());
+        return 2;
     }
-};
+    if (opts.headless || !opts.record.empty()) return run_headless(opts);
 
-class NetworkSensor : public Sensor {
-public:
-    bool is_compatible(const std::string& path) override {
-        return fs::exists(path + "/operstate");
+    AlertEngine alerts;
+    std::string rules = alert_rules_path(opts.alerts);
+    if (!rules.empty() && !alerts.load(rules, error)) {
+        std::fprintf(stderr, "kmap: %s\n", error.c_str());
+        return 2;
     }
 
-    Element render(const std::string& path) override {
-        std::string state = read_file(path + "/operstate");
-        auto state_color = (state == "up") ? Color::Green : Color::Red;
+    auto screen = ScreenInteractive::Fullscreen();
 
-        Elements lines;
-        lines.push_back(hbox({
-            text("Link State: "),
-            text(state) | bold | color(state_color)
-        }));
+    auto drivers = make_default_drivers();
+    std::vector<Category> categories = default_categories();
 
-        std::string mac = read_file(path + "/address");
-        if (!mac.empty()) lines.push_back(text("MAC: " + mac));
+    int selected_category = 0;
+    int selected_device = 0;
+    DeviceList devices;
+    std::string devices_placeholder;  // shown when `devices` is empty
+    std::string pending_selection;    // reselected once `devices` finishes loading
+    bool category_missing = false;
+    BindingTable bindings;
+    uint64_t bindings_generation = 0;  // bumped whenever `bindings` or `watched` changes
+    bool overview = false;
 
-        std::string rx = read_file(path + "/statistics/rx_bytes");
-        if (!rx.empty()) lines.push_back(text("Data Rx: " + rx + " bytes"));
+    // Background threads ask for redraws through the limiter, which is
+    // declared after `screen` and before them so they stop first.
+    RedrawLimiter redraw(opts.max_fps, [&] { screen.PostEvent(Event::Custom); });
+    // Alerts fire on the sampler workers and reach the UI through a queue
+    // drained once per frame; a transition wakes the UI even when the
+    // values it shows didn't change.
+    AlertQueue alert_events;
+    alerts.add_sink(&alert_events, [&] { redraw.request(); });
+    std::unique_ptr<AlertHook> hook;
+    if (!opts.alert_hook.empty() && !alerts.empty()) hook = std::make_unique<AlertHook>(opts.alert_hook, alerts);
+    Sampler sampler(opts.interval, [&] { redraw.request(); }, opts.sampler_threads,
+                    alerts.empty() ? nullptr : &alerts);
+    // Left running in a detached tmux, kmap should cost next to nothing:
+    // sampling slows down after a while without input (or as soon as the
+    // terminal reports losing focus) and any key brings it back at once.
+    constexpr std::chrono::milliseconds kIdleInterval{10000};
+    sampler.set_cpu_budget(opts.max_cpu);
+    sampler.set_idle(opts.idle_after, kIdleInterval);
+    HotplugMonitor hotplug([&] { redraw.request(); });
 
-        return vbox(lines);
+    // Remote and replay modes: devices come from the source instead of
+    // local sysfs.
+    std::unique_ptr<SnapshotSource> source;
+    Replayer* replayer = nullptr;
+    RemoteClient* remote = nullptr;
+    if (!opts.replay.empty()) {
+        auto replay = std::make_unique<Replayer>(opts.replay, drivers, [&] { redraw.request(); });
+        if (!replay->ok()) {
+            std::fprintf(stderr, "kmap: %s\n", replay->error().c_str());
+            return 1;
+        }
+        replayer = replay.get();
+        source = std::move(replay);
+    } else if (!opts.connect.empty()) {
+        auto client = std::make_unique<RemoteClient>(opts.connect, drivers, [&] { redraw.request(); });
+        remote = client.get();
+        source = std::move(client);
     }
-};
+    uint64_t source_layout = 0;
 
-class PowerSensor : public Sensor {
-public:
-    bool is_compatible(const std::string& path) override {
-        return fs::exists(path + "/capacity");
+    // Local categories are listed and bound in the background: the first
+    // frame goes up with placeholders, and the selected category is shown
+    // as soon as its result lands.
+    std::unique_ptr<Discovery> discovery;
+    if (!source) {
+        discovery = std::make_unique<Discovery>(categories, drivers, opts.sampler_threads, [&] { redraw.request(); });
     }
+    std::vector<bool> stale(categories.size(), false);  // uevents since the category was discovered
+    bool discovering = false;  // the selected category's result isn't in yet
+    auto latest = [&]() { return source ? source->latest() : sampler.latest(); };
 
-    Element render(const std::string& path) override {
-        std::string cap = read_file(path + "/capacity");
-        std::string status = read_file(path + "/status");
-        
-        return vbox({
-            text("Battery Level: " + cap + "%") | bold,
-            text("Status: " + status)
-        });
+    // Scrapes read whatever was published last: every device either way,
+    // since the metrics endpoint has all of them sampled (see `watched`).
+    std::unique_ptr<MetricsServer> metrics;
+    if (!opts.metrics_listen.empty()) {
+        metrics = std::make_unique<MetricsServer>(opts.metrics_listen, latest);
+        if (!metrics->ok()) {
+            std::fprintf(stderr, "kmap: %s\n", metrics->error().c_str());
+            return 1;
+        }
     }
-};
 
-int main() {
-    auto screen = ScreenInteractive::Fullscreen();
+    // Source devices of the selected category; remote ones as "<host>:<device>".
+    auto list_source = [&](const std::string& root, std::vector<Binding>& out) {
+        std::vector<std::pair<std::string, Binding>> found;
+        if (auto set = source->latest()) {
+            for (const auto& snap : set->devices) {
+                size_t slash = snap.path.find('/');
+                size_t colon = snap.path.rfind(':', slash);
+                size_t start = colon == std::string::npos ? 0 : colon + 1;
+                if (snap.path.compare(start, root.size() + 1, root + "/") != 0) continue;
+                std::string name = snap.path.substr(start + root.size() + 1);
+                if (start) name = snap.path.substr(0, start) + name;
+                found.push_back({std::move(name), Binding{snap.path, snap.driver}});
+            }
+        }
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<std::string> names;
+        out.clear();
+        for (auto& entry : found) {
+            names.push_back(std::move(entry.first));
+            out.push_back(std::move(entry.second));
+        }
+        return names;
+    };
 
-    std::vector<std::unique_ptr<Sensor>> drivers;
-    drivers.push_back(std::make_unique<ThermalSensor>());
-    drivers.push_back(std::make_unique<NetworkSensor>());
-    drivers.push_back(std::make_unique<PowerSensor>());
+    // Directory entries merged per frame while a category is loading; a
+    // typical class fits in the first one.
+    constexpr size_t kListBudget = 2048;
 
-    std::vector<std::pair<std::string, std::string>> categories = {
-        {"🔥 Thermals", "/sys/class/thermal"},
-        {"🌐 Network",  "/sys/class/net"},
-        {"⚡ Power",    "/sys/class/power_supply"},
-        {"💡 LEDs",     "/sys/class/leds"}
+    auto select_named = [&](const std::string& name) {
+        size_t index = name.empty() ? DeviceList::npos : devices.find(name);
+        selected_device = index == DeviceList::npos ? 0 : static_cast<int>(index);
     };
 
-    int selected_category = 0;
-    int selected_device = 0;
-    std::vector<std::string> devices;
-
-    auto refresh_devices = [&]() {
-        devices.clear();
-        std::string target = categories[selected_category].second;
-        if (fs::exists(target)) {
-            for (const auto& entry : fs::directory_iterator(target)) {
-                devices.push_back(entry.path().filename().string());
-            }
-            std::sort(devices.begin(), devices.end());
-        } else {
-            devices.push_back("(Category not found)");
+    // Bindings are (re)built once the whole directory is listed.
+    auto finish_listing = [&]() {
+        bindings.rebuild(categories[selected_category].root, devices, drivers);
+        ++bindings_generation;
+        if (!pending_selection.empty()) select_named(pending_selection);
+    };
+
+    auto refresh_devices = [&](bool keep_selection = false) {
+        pending_selection = keep_selection && selected_device < static_cast<int>(devices.size())
+                                ? std::string(devices.at(selected_device)) : "";
+        std::string target = categories[selected_category].root;
+        if (source) {
+            source_layout = source->layout();
+            std::vector<Binding> found;
+            devices.assign(list_source(target, found));
+            category_missing = devices.empty();
+            devices_placeholder = replayer ? "(Not in recording)" : "(No remote devices)";
+            bindings.assign(std::move(found));
+            ++bindings_generation;
+            select_named(pending_selection);
+            return;
+        }
+
+        const Category& category = categories[selected_category];
+        bindings.clear();
+        ++bindings_generation;
+        selected_device = 0;
+        if (!category.device.empty()) {
+            devices.assign(category.list());
+            category_missing = devices.empty();
+            devices_placeholder = "(Category not found)";
+            finish_listing();
+            return;
+        }
+
+        category_missing = !devices.open(target);
+        devices_placeholder = category_missing ? "(Category not found)" : "(No devices)";
+        if (devices.step(kListBudget)) finish_listing();
+    };
+
+    // Shows the selected category from its discovery result while that is
+    // current, else lists it afresh. Returns true in the latter case.
+    auto show_category = [&]() {
+        discovering = false;
+        const Discovery::Result* found = discovery ? discovery->result(selected_category) : nullptr;
+        if (discovery && !found && !discovery->done()) {
+            devices.assign({});
+            bindings.clear();
+            ++bindings_generation;
+            selected_device = 0;
+            category_missing = false;
+            devices_placeholder = "(Discovering...)";
+            discovering = true;
+            return false;
         }
+        if (!found || stale[selected_category]) {
+            refresh_devices();
+            return true;
+        }
+        devices.assign(found->names);
+        bindings.assign(found->bindings);
+        ++bindings_generation;
         selected_device = 0;
+        category_missing = found->missing;
+        devices_placeholder = category_missing ? "(Category not found)" : "(No devices)";
+        return false;
+    };
+
+    // Devices an alert rule applies to are sampled every pass along with
+    // whatever is on screen, so alerts don't depend on the selection; with
+    // --metrics-listen that is every device, so scrapes see all of them.
+    std::vector<Binding> watched;
+    bool watch_pending = false;  // waiting for discovery to bind every category
+    bool watch_none = alerts.empty() && !metrics;
+    auto watches = [&](const std::string& path) { return metrics || alerts.watches(path); };
+    auto rewatch = [&]() {
+        watched.clear();
+        watch_pending = false;
+        if (watch_none || source) return;
+        for (auto& binding : bind_categories(categories, drivers)) {
+            if (watches(binding.path)) watched.push_back(std::move(binding));
+        }
+        ++bindings_generation;
+    };
+    // A uevent only changes its own device's binding, so it is applied to
+    // `watched` in place rather than rebinding every category on the UI
+    // thread. Events that arrive before discovery is done wait for it.
+    std::vector<HotplugEvent> watch_events;
+    auto watch_event = [&](const HotplugEvent& event) {
+        if (watch_none || source) return;
+        if (watch_pending) {
+            watch_events.push_back(event);
+            return;
+        }
+        for (const auto& category : categories) {
+            if (category.subsystem() != event.subsystem) continue;
+            std::string path = category.root + "/" + event.name;
+            auto it = std::find_if(watched.begin(), watched.end(), [&](const Binding& b) { return b.path == path; });
+            if (event.action == HotplugEvent::Action::Add) {
+                if (it != watched.end() || !watches(path)) continue;
+                Binding binding = bind_device(category.root, event.name, drivers);
+                if (!binding.driver) continue;
+                watched.push_back(std::move(binding));
+            } else {
+                if (it == watched.end()) continue;
+                sampler.forget(*it);
+                watched.erase(it);
+            }
+            ++bindings_generation;
+        }
+    };
+    auto watch_discovered = [&]() {
+        watch_pending = false;
+        for (size_t i = 0; i < categories.size(); ++i) {
+            for (const auto& binding : discovery->result(i)->bindings) {
+                if (binding.driver && watches(binding.path)) watched.push_back(binding);
+            }
+        }
+        ++bindings_generation;
+        for (const auto& event : watch_events) watch_event(event);
+        watch_events.clear();
+    };
+    if (discovery) {
+        watch_pending = !watch_none;
+    } else {
+        rewatch();
+    }
+
+    // Takes the queued uevents, marking the categories they touch as
+    // changed since discovery.
+    auto drain_hotplug = [&]() {
+        std::vector<HotplugEvent> events = hotplug.drain();
+        // uevents name the host's devices, which another backend doesn't show.
+        if (!host_sysfs()) events.clear();
+        for (const auto& event : events) {
+            for (size_t i = 0; i < categories.size(); ++i) {
+                if (categories[i].subsystem() == event.subsystem) stale[i] = true;
+            }
+        }
+        return events;
+    };
+
+    // Applies queued uevents to `devices`/`bindings` in place, keeping the
+    // same device selected when it still exists. While the list is still
+    // loading only `devices` changes; the bindings follow when it's done.
+    // While the category is still being discovered nothing is applied: its
+    // result is stale by then and it is listed afresh instead.
+    auto apply_hotplug = [&]() {
+        const Category& category = categories[selected_category];
+        const std::string subsystem = category.subsystem();
+        for (const auto& event : drain_hotplug()) {
+            watch_event(event);
+            if (event.subsystem != subsystem || discovering) continue;
+            if (category_missing) {
+                refresh_devices();
+                continue;
+            }
+
+            std::string selected = devices.empty() ? "" : std::string(devices.at(selected_device));
+            if (event.action == HotplugEvent::Action::Add) {
+                size_t index = devices.insert(event.name);
+                if (index == DeviceList::npos) continue;
+                if (!devices.loading()) bindings.insert(index, category.root, event.name, drivers);
+            } else {
+                size_t index = devices.find(event.name);
+                if (index == DeviceList::npos) continue;
+                if (!devices.loading()) {
+                    sampler.forget(*bindings.at(static_cast<int>(index)));
+                    bindings.erase(index);
+                }
+                devices.erase(event.name);
+            }
+            if (devices.loading()) continue;
+            ++bindings_generation;
+
+            selected_device = static_cast<int>(devices.lower_bound(selected));
+            if (selected_device >= static_cast<int>(devices.size())) {
+                selected_device = static_cast<int>(devices.size()) - 1;
+            }
+            if (selected_device < 0) selected_device = 0;
+        }
     };
-    refresh_devices();
 
     // Components
     std::vector<std::string> cat_names;
-    for(auto& c : categories) cat_names.push_back(c.first);
+    for(auto& c : categories) cat_names.push_back(c.label);
     
     auto menu_cat = Menu(&cat_names, &selected_category, MenuOption::Vertical());
-    auto menu_dev = Menu(&devices, &selected_device, MenuOption::Vertical());
+    auto menu_dev = DeviceMenu(&devices, &selected_device, &devices_placeholder);
 
     // Layout & Rendering
     auto layout = Container::Horizontal({ menu_cat, menu_dev });
 
+    // `t`: generic browser over the rest of sysfs. It gets keys before the
+    // menus while open. Under --sysfs-root it browses that tree; a synthetic
+    // backend has no files to browse, so the host's are shown.
+    bool show_tree = false;
+    std::vector<std::string> tree_roots;
+    for (const char* root : {"/sys/class", "/sys/devices", "/sys/bus"}) {
+        std::string host = attr_backend().host_path(root);
+        tree_roots.push_back(host.empty() ? root : host);
+    }
+    SysfsTree tree(std::move(tree_roots));
+    std::string tree_path;
+    std::string tree_filter;
+    auto explorer = TreeExplorer(&tree, &tree_path, &tree_filter);
+
+    // `/`: filters the device list, or the tree while it is open. Keys go
+    // to the prompt until Enter (keeps the filter) or Esc (clears it).
+    bool filtering = false;
+    std::string device_filter;
+    auto apply_filter = [&]() {
+        if (show_tree) return;  // the explorer reads tree_filter itself
+        devices.set_filter(device_filter);
+        // Onto a shown row, so the panel follows what the menu highlights.
+        size_t row = devices.row_of(selected_device);
+        if (row < devices.rows()) {
+            selected_device = static_cast<int>(devices.index_at(row));
+        } else if (devices.rows()) {
+            selected_device = static_cast<int>(devices.index_at(devices.rows() - 1));
+        }
+    };
+    auto filter_line = [&](const std::string& filter) {
+        if (!filtering && filter.empty()) return emptyElement();
+        Element line = text("/" + filter + (filtering ? "█" : "")) | color(Color::Yellow);
+        return vbox({line, separator()});
+    };
+
+    // Parts of the frame that never change, built once.
+    Element title = text(" LINUX KERNEL MONITOR (v2 OOP) ") | bold | hcenter | bgcolor(Color::Blue);
+    Element footer = text(remote ? " q: Quit | /: Filter | o: Overview | r: Rack | p: Profile | t: Tree | Arrow Keys: Navigate "
+                                 : " q: Quit | /: Filter | o: Overview | p: Profile | t: Tree | Arrow Keys: Navigate ") | hcenter;
+
+    // Replay position, e.g. "01:02:03"; changes every tick, so not cached.
+    auto clock_text = [](int64_t ns) {
+        long s = static_cast<long>(ns / 1000000000);
+        char buf[32];  // room for three longs, however long the recording
+        std::snprintf(buf, sizeof(buf), "%02ld:%02ld:%02ld", s / 3600, s / 60 % 60, s % 60);
+        return std::string(buf);
+    };
+    auto replay_footer = [&]() {
+        Replayer::Status st = replayer->status();
+        std::string state = (st.paused ? " PAUSED " : " PLAYING ") + std::to_string(st.speed) + "x ";
+        return hbox({
+            text(state) | bold | color(st.paused ? Color::Yellow : Color::Green),
+            text(clock_text(st.position_ns) + " / " + clock_text(st.length_ns)),
+            text(" | space: Pause | s: 1x/10x | [ ]: Seek 30s | { }: Seek 5m | q: Quit ") | flex,
+        }) | hcenter;
+    };
+
+    // Sampler targets are only recomputed when what they depend on changes.
+    uint64_t targets_generation = ~0ull;
+    int targets_device = -1;
+    bool targets_overview = false;
+    auto update_targets = [&]() {
+        if (targets_generation == bindings_generation && targets_device == selected_device &&
+            targets_overview == overview) {
+            return;
+        }
+        targets_generation = bindings_generation;
+        targets_device = selected_device;
+        targets_overview = overview;
+        if (source) return;  // the source has every device already
+
+        std::vector<Binding> targets;
+        std::unordered_set<std::string_view> sampled;  // paths in `bindings` and `watched`
+        if (overview) {
+            // The whole category is sampled in one batched pass.
+            for (size_t i = 0; i < bindings.size(); ++i) {
+                const Binding* b = bindings.at(static_cast<int>(i));
+                if (!b->driver) continue;
+                targets.push_back(*b);
+                sampled.insert(b->path);
+            }
+        } else if (const Binding* b = bindings.at(selected_device)) {
+            targets.push_back(*b);
+            sampled.insert(b->path);
+        }
+        for (const auto& b : watched) {
+            if (sampled.insert(b.path).second) targets.push_back(b);
+        }
+        sampler.set_targets(std::move(targets));
+    };
+
+    // Self-profiling: render time per driver and build time per frame.
+    bool show_profile = false;
+    LatencyHistogram* frame_latency = profiler().histogram("frame");
+    std::map<const Sensor*, LatencyHistogram*> render_latency;
+    for (const auto& driver : drivers) {
+        render_latency[driver.get()] = profiler().histogram(std::string("render:") + driver->name());
+    }
+    auto render_histogram = [&](const Sensor* driver) -> LatencyHistogram* {
+        auto it = render_latency.find(driver);
+        return it == render_latency.end() ? nullptr : it->second;
+    };
+
+    // Panels are only rebuilt when the sampler publishes something new for
+    // them (it skips publishing when nothing changed).
+    std::string detail_path;
+    uint64_t cached_version = 0;
+    Element cached_detail;
+    std::shared_ptr<const SnapshotSet> cached_set;
+    int cached_grid_category = -1;
+    Element cached_grid;
+    std::string cached_path;  // what path_line shows
+    Element path_line;
+
+    auto render_detail = [&](const SnapshotSet* set, const std::string& full_path) {
+        const Snapshot* snap = set ? set->find(full_path) : nullptr;
+        if (!snap) {
+            detail_path.clear();
+            return text("Sampling...") | color(Color::GrayLight);
+        }
+        if (snap->path != detail_path || snap->version != cached_version || !cached_detail) {
+            detail_path = snap->path;
+            cached_version = snap->version;
+            if (snap->driver) {
+                ScopedTimer timer(render_histogram(snap->driver));
+                cached_detail = snap->driver->render(*snap);
+            } else {
+                cached_detail = text("No driver matched for this device.") | color(Color::GrayLight);
+            }
+        }
+        return cached_detail;
+    };
+
+    auto render_overview = [&](const std::shared_ptr<const SnapshotSet>& set, const std::string& full_path) {
+        if (!set) return text("Sampling...") | color(Color::GrayLight);
+        if (set != cached_set || cached_grid_category != selected_category || !cached_grid) {
+            cached_set = set;
+            cached_grid_category = selected_category;
+            Elements cards;
+            const std::string root = categories[selected_category].root + "/";
+            for (const auto& snap : set->devices) {
+                // Sets also hold watched devices, and remote ones hold every
+                // category.
+                size_t colon = snap.path.rfind(':', snap.path.find('/'));
+                size_t start = colon == std::string::npos ? 0 : colon + 1;
+                if (snap.path.compare(start, root.size(), root) != 0) continue;
+                std::string name = snap.path.substr(snap.path.rfind('/') + 1);
+                Element title = text(" " + name + " ");
+                if (snap.path == full_path) title = title | bold | color(Color::Yellow);
+                // Remote and replayed devices may name a driver this build lacks.
+                if (!snap.driver) {
+                    cards.push_back(window(title, text("No driver") | color(Color::GrayLight)) |
+                                    size(WIDTH, EQUAL, 26));
+                    continue;
+                }
+                ScopedTimer timer(render_histogram(snap.driver));
+                cards.push_back(window(title, snap.driver->summary(snap)) | size(WIDTH, EQUAL, 26));
+            }
+            cached_grid = cards.empty() ? text("No supported devices in this category.") | color(Color::GrayLight)
+                                        : hflow(cards);
+        }
+        return cached_grid;
+    };
+
+    // Latency table for the `p` overlay: fixed rows first, then the slowest
+    // attributes by p99.
+    auto render_profile = [&]() {
+        constexpr size_t kTopAttributes = 12;
+        std::vector<Profiler::Entry> fixed;
+        std::vector<Profiler::Entry> attrs;
+        for (auto& entry : profiler().entries()) {
+            if (entry.histogram->count() == 0) continue;
+            (entry.name[0] == '/' ? attrs : fixed).push_back(std::move(entry));
+        }
+        size_t top = std::min(attrs.size(), kTopAttributes);
+        std::partial_sort(attrs.begin(), attrs.begin() + top, attrs.end(),
+                          [](const Profiler::Entry& a, const Profiler::Entry& b) {
+                              return a.histogram->percentile(0.99) > b.histogram->percentile(0.99);
+                          });
+        attrs.resize(top);
+
+        std::vector<Elements> rows;
+        rows.push_back({text("NAME ") | bold, text(" COUNT") | bold, text("     P50") | bold,
+                        text("     P99") | bold, text("     MAX") | bold});
+        auto add = [&](const Profiler::Entry& entry) {
+            const LatencyHistogram& h = *entry.histogram;
+            rows.push_back({text(entry.name + " "), text(" " + std::to_string(h.count())) | align_right,
+                            text(" " + format_latency(h.percentile(0.5))) | align_right,
+                            text(" " + format_latency(h.percentile(0.99))) | align_right,
+                            text(" " + format_latency(h.max())) | align_right});
+        };
+        for (const auto& entry : fixed) add(entry);
+        for (const auto& entry : attrs) add(entry);
+
+        Sampler::Pacing pacing = sampler.pacing();
+        char line[96];
+        std::snprintf(line, sizeof(line), "Sampling every %s%s, CPU %.2f%%", format_latency(pacing.period_ns).c_str(),
+                      pacing.idle ? " (idle)" : "", pacing.cpu_usage * 100);
+        std::string status = line;
+        if (opts.max_cpu > 0) {
+            std::snprintf(line, sizeof(line), " of %.2f%%", opts.max_cpu * 100);
+            status += line;
+        }
+        return window(text(" PROFILE (p to close) ") | bold, vbox({gridbox(rows), separator(), text(status)})) |
+               clear_under | center;
+    };
+
+    // `r` in remote mode: the hosts ranked by each rack column, re-ranked
+    // every frame with a partial sort, so only the shown rows are ordered.
+    bool show_rack = false;
+    std::vector<uint32_t> rack_order;  // reused between rankings
+    auto render_rack = [&]() {
+        constexpr size_t kRackTop = 10;
+        auto rack = remote->rack();
+        if (!rack) return text("Waiting for agents...") | color(Color::GrayLight);
+        const std::vector<std::string>& hosts = *rack->hosts;
+        auto ranking = [&](const char* heading, RackColumns::Metric metric, auto format) {
+            top_hosts(*rack, metric, kRackTop, rack_order);
+            std::vector<Elements> rows;
+            for (uint32_t i : rack_order) {
+                rows.push_back({text(hosts[i] + " "), text(" " + format(rack->columns[metric][i])) | align_right});
+            }
+            Element table = rows.empty() ? text("No readings") | color(Color::GrayLight) : gridbox(std::move(rows));
+            return window(text(heading) | bold, table) | flex;
+        };
+        size_t up = std::count(rack->connected.begin(), rack->connected.end(), 1);
+        return vbox({
+            text(" " + std::to_string(up) + "/" + std::to_string(hosts.size()) + " hosts connected") |
+                color(up == hosts.size() ? Color::Green : Color::Yellow),
+            hbox({
+                ranking(" HOTTEST ", RackColumns::kTemp, [](int64_t v) { return format_scaled(v, 1000, "°C"); }),
+                ranking(" BUSIEST LINKS ", RackColumns::kNet,
+                        [](int64_t v) { return format_rate(static_cast<double>(v), "B"); }),
+                ranking(" BUSIEST CPUS ", RackColumns::kCpu, [](int64_t v) { return format_scaled(v, 10, "%"); }),
+            }),
+        });
+    };
+
+    // Raised alerts, oldest first; the newest is shown above the footer.
+    std::vector<AlertEvent> active_alerts;
+    Element alert_line;
+    auto drain_alerts = [&]() {
+        AlertEvent event;
+        while (alert_events.pop(event)) {
+            active_alerts.erase(std::remove_if(active_alerts.begin(), active_alerts.end(),
+                                               [&](const AlertEvent& a) {
+                                                   return a.rule == event.rule && a.device == event.device;
+                                               }),
+                                active_alerts.end());
+            if (event.raised) active_alerts.push_back(event);
+            alert_line = nullptr;
+        }
+        if (active_alerts.empty() || alert_line) return;
+        std::string line = " ⚠ " + alerts.describe(active_alerts.back());
+        if (active_alerts.size() > 1) line += "  (+" + std::to_string(active_alerts.size() - 1) + " more)";
+        alert_line = text(line + " ") | bold | color(Color::White) | bgcolor(Color::Red);
+    };
+
+    int64_t first_frame_ns = 0;
+    int64_t populated_ns = 0;
+
     auto renderer = Renderer(layout, [&] {
+        ScopedTimer frame_timer(frame_latency);
         static int last_cat = -1;
         if (last_cat != selected_category) {
-            refresh_devices();
+            // A fresh listing already has what the queued uevents say; a
+            // discovery result gets them applied below.
+            // A filter is for the category it was typed in.
+            device_filter.clear();
+            devices.set_filter("");
+            if (show_category()) drain_hotplug();
             last_cat = selected_category;
+        } else if (discovering && (discovery->result(selected_category) || discovery->done())) {
+            if (show_category()) drain_hotplug();
+        }
+        if (watch_pending && discovery->done()) watch_discovered();
+        if (source) {
+            if (source->layout() != source_layout) refresh_devices(true);
+        } else {
+            apply_hotplug();
+        }
+        if (devices.loading()) {
+            if (devices.step(kListBudget)) {
+                finish_listing();
+            } else {
+                redraw.request();
+            }
         }
 
-        std::string current_root = categories[selected_category].second;
-        std::string current_device = (devices.empty()) ? "" : devices[selected_device];
-        std::string full_path = current_root + "/" + current_device;
+        const Binding* binding = bindings.at(selected_device);
+        const std::string full_path = binding ? binding->path : categories[selected_category].root + "/";
+        update_targets();
+        drain_alerts();
 
-        Element detail_view = text("No driver matched for this device.") | color(Color::GrayLight);
-        
-        for (const auto& driver : drivers) {
-            if (driver->is_compatible(full_path)) {
-                detail_view = driver->render(full_path);
-                break; 
-            }
+        // Rendering only formats whatever the sampler published last.
+        auto set = latest();
+        Element panel = discovering ? text("Discovering devices...") | color(Color::GrayLight)
+                      : show_rack   ? render_rack()
+                      : overview    ? render_overview(set, full_path)
+                                    : render_detail(set.get(), full_path);
+        if (full_path != cached_path || !path_line) {
+            cached_path = full_path;
+            path_line = text(" Path: " + full_path) | color(Color::GrayLight);
         }
-        // ---------------------------------------------
 
-        return vbox({
-            text(" LINUX KERNEL MONITOR (v2 OOP) ") | bold | hcenter | bgcolor(Color::Blue),
-            separator(),
-            hbox({
+        Element body;
+        if (show_tree) {
+            Element rows = explorer->Render();
+            body = vbox({
+                text(" SYSFS TREE (t to close) ") | bold | hcenter,
+                separator(),
+                filter_line(tree_filter),
+                rows | flex,
+                text(" Path: " + tree_path) | color(Color::GrayLight)
+            }) | border | flex;
+        } else {
+            body = hbox({
                 vbox({ text("SUBSYSTEMS") | bold | hcenter, separator(), menu_cat->Render() }) | border | size(WIDTH, EQUAL, 20),
-                vbox({ text("DEVICES") | bold | hcenter, separator(), menu_dev->Render() | vscroll_indicator | frame }) | border | size(WIDTH, EQUAL, 30),
+                vbox({ text("DEVICES") | bold | hcenter, separator(), filter_line(device_filter), menu_dev->Render() }) | border | size(WIDTH, EQUAL, 30),
                 vbox({ 
-                    text(" LIVE METRICS ") | bold | hcenter, 
-                    separator(), 
-                    detail_view,
+                    text(show_rack ? " RACK " : overview ? " OVERVIEW " : " LIVE METRICS ") | bold | hcenter,
+                    separator(),
+                    panel,
                     filler(),
-                    text(" Path: " + full_path) | color(Color::GrayLight)
+                    path_line
                 }) | border | flex
-            }) | flex,
-            text(" q: Quit | Arrow Keys: Navigate ") | hcenter
-        });
+            }) | flex;
+        }
+
+        // --startup-trace: the first frame built, and the first showing
+        // every category discovered and the selected device sampled.
+        int64_t now = monotonic_ns();
+        if (!first_frame_ns) first_frame_ns = now - start_ns;
+        if (!populated_ns && !discovering && !devices.loading() && (!discovery || discovery->done()) &&
+            (!binding || !binding->driver || (set && set->find(full_path)))) {
+            populated_ns = now - start_ns;
+        }
+
+        Elements frame = {title, separator(), body};
+        if (!active_alerts.empty()) frame.push_back(alert_line);
+        frame.push_back(replayer ? replay_footer() : footer);
+        Element screen_body = vbox(std::move(frame));
+        if (!show_profile) return screen_body;
+        return dbox({screen_body, render_profile()});
     });
 
+    // Focus reports (xterm mode 1004, tmux with focus-events on) arrive as
+    // these sequences.
+    const std::string kFocusIn = "\x1b[I";
+    const std::string kFocusOut = "\x1b[O";
+
     auto component = CatchEvent(renderer, [&](Event event) {
+        // Anything but our own redraw requests is the user: keys, mouse,
+        // resizes (FTXUI posts one per SIGWINCH) and focus reports.
+        if (event != Event::Custom) {
+            if (event.input() == kFocusOut) {
+                sampler.go_idle();
+                return true;
+            }
+            sampler.activity();
+            if (event.input() == kFocusIn) return true;
+        }
+        std::string& filter = show_tree ? tree_filter : device_filter;
+        if (filtering) {
+            if (event == Event::Escape) {
+                filter.clear();
+                filtering = false;
+            } else if (event == Event::Return) {
+                filtering = false;
+            } else if (event == Event::Backspace) {
+                if (!filter.empty()) filter.pop_back();
+            } else if (event.is_character()) {
+                filter += event.character();
+            } else {
+                return false;  // arrows still move through the results
+            }
+            apply_filter();
+            return true;
+        }
+        if (event == Event::Character('/')) {
+            filtering = true;
+            return true;
+        }
+        if (event == Event::Escape && !filter.empty()) {
+            filter.clear();
+            apply_filter();
+            return true;
+        }
         if (event == Event::Character('q')) {
             screen.Exit();
             return true;
         }
+        if (event == Event::Character('o')) {
+            overview = !overview;
+            return true;
+        }
+        if (event == Event::Character('r') && remote) {
+            show_rack = !show_rack;
+            return true;
+        }
+        if (event == Event::Character('p')) {
+            show_profile = !show_profile;
+            return true;
+        }
+        if (event == Event::Character('t')) {
+            show_tree = !show_tree;
+            return true;
+        }
+        if (show_tree && explorer->OnEvent(event)) return true;
+        if (replayer) {
+            constexpr int64_t kSecond = 1000000000;
+            if (event == Event::Character(' ')) replayer->toggle_pause();
+            else if (event == Event::Character('s')) replayer->toggle_speed();
+            else if (event == Event::Character('[')) replayer->seek(-30 * kSecond);
+            else if (event == Event::Character(']')) replayer->seek(30 * kSecond);
+            else if (event == Event::Character('{')) replayer->seek(-300 * kSecond);
+            else if (event == Event::Character('}')) replayer->seek(300 * kSecond);
+            else return false;
+            return true;
+        }
         return false;
     });
 
+    const bool focus_reports = ::isatty(STDOUT_FILENO);
+    if (focus_reports) std::fputs("\x1b[?1004h", stdout);
     screen.Loop(component);
+    if (focus_reports) {
+        std::fputs("\x1b[?1004l", stdout);
+        std::fflush(stdout);
+    }
+
+    if (opts.startup_trace) {
+        auto ms = [](int64_t ns) { return static_cast<double>(ns) / 1e6; };
+        std::fprintf(stderr, "kmap: first frame after %.1f ms\n", ms(first_frame_ns));
+        if (populated_ns) {
+            std::fprintf(stderr, "kmap: fully populated after %.1f ms\n", ms(populated_ns));
+        } else {
+            std::fprintf(stderr, "kmap: not fully populated before exit\n");
+        }
+        if (discovery && discovery->done()) {
+            std::fprintf(stderr, "kmap: discovery took %.1f ms on %zu thread%s\n", ms(discovery->elapsed_ns()),
+                         discovery->threads(), discovery->threads() == 1 ? "" : "s");
+            for (size_t i = 0; i < categories.size(); ++i) {
+                const Discovery::Result* found = discovery->result(i);
+                std::fprintf(stderr, "kmap:   %-8s %6zu devices %8.1f ms\n", categories[i].id.c_str(),
+                             found->names.size(), ms(found->elapsed_ns));
+            }
+        }
+    }
     return 0;
 }
\ No newline at end of file
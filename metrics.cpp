@@ -0,0 +1,304 @@
+#include "metrics.hpp"
+
+#include "paths.hpp"
+#include "sockets.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// --- OpenMetricsWriter ---
+
+// Metric and label names: [a-zA-Z0-9_], with a "/s" rate suffix spelled out.
+static void append_name(std::string_view s, std::string& out) {
+    bool per_second = s.size() > 2 && s.compare(s.size() - 2, 2, "/s") == 0;
+    if (per_second) s.remove_suffix(2);
+    for (char c : s) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        out.push_back(ok ? c : '_');
+    }
+    if (per_second) out.append("_per_second");
+}
+
+static void append_label_value(std::string_view s, std::string& out) {
+    out.push_back('"');
+    for (char c : s) {
+        switch (c) {
+        case '"':  out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        default:   out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+static void append_int(int64_t value, std::string& out) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr);
+}
+
+void OpenMetricsWriter::write(const SnapshotSet& set, std::string& out) {
+    constexpr uint32_t kInfo = ~0u;
+    out.clear();
+    samples_.clear();
+    for (uint32_t i = 0; i < set.devices.size(); ++i) {
+        const Snapshot& snap = set.devices[i];
+        if (!snap.driver) continue;
+        const char* driver = snap.driver->name();
+        for (uint32_t k = 0; k < snap.numbers.size(); ++k) {
+            std::string_view key = snap.numbers[k].first;
+            size_t dot = key.find('.');
+            name_.assign("kmap_").append(driver).push_back('_');
+            append_name(dot == std::string_view::npos ? key : key.substr(dot + 1), name_);
+            samples_.push_back({paths().key(name_), i, k});
+        }
+        if (!snap.values.empty()) {
+            name_.assign("kmap_").append(driver);
+            samples_.push_back({paths().key(name_), i, kInfo});
+        }
+    }
+    // A family's samples must be contiguous, under one TYPE line.
+    std::stable_sort(samples_.begin(), samples_.end(),
+                     [](const Sample& a, const Sample& b) { return a.family < b.family; });
+
+    std::string_view family;
+    for (const Sample& sample : samples_) {
+        const Snapshot& snap = set.devices[sample.snap];
+        const bool info = sample.value == kInfo;
+        if (sample.family != family) {
+            family = sample.family;
+            out.append("# TYPE ").append(family).append(info ? " info\n" : " gauge\n");
+        }
+
+        out.append(family);
+        if (info) out.append("_info");
+        size_t slash = snap.path.rfind('/');
+        out.append("{device=");
+        append_label_value(std::string_view(snap.path).substr(slash == std::string::npos ? 0 : slash + 1), out);
+        out.append(",path=");
+        append_label_value(snap.path, out);
+        if (info) {
+            for (const auto& [key, value] : snap.values) {
+                out.push_back(',');
+                append_name(key, out);
+                out.push_back('=');
+                append_label_value(value, out);
+            }
+            out.append("} 1\n");
+            continue;
+        }
+        const auto& [key, value] = snap.numbers[sample.value];
+        size_t dot = key.find('.');
+        if (dot != std::string_view::npos) {
+            out.append(",channel=");
+            append_label_value(key.substr(0, dot), out);
+        }
+        out.append("} ");
+        append_int(value, out);
+        out.push_back('\n');
+    }
+    out.append("# EOF\n");
+}
+
+// --- MetricsServer ---
+
+MetricsServer::MetricsServer(const std::string& address, Latest latest) : latest_(std::move(latest)) {
+    listen_fd_ = listen_socket(address, error_);
+    if (listen_fd_ < 0) return;
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (!set_nonblocking(listen_fd_) || epoll_fd_ < 0 || wake_fd_ < 0) {
+        error_ = address + ": " + std::strerror(errno);
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &listen_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.ptr = &wake_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    thread_ = std::thread(&MetricsServer::run, this);
+}
+
+MetricsServer::~MetricsServer() {
+    if (thread_.joinable()) {
+        stop_ = true;
+        uint64_t one = 1;
+        ssize_t n = ::write(wake_fd_, &one, sizeof(one));
+        (void)n;
+        thread_.join();
+    }
+    for (auto& conn : connections_) close(*conn);
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+}
+
+void MetricsServer::run() {
+    epoll_event events[32];
+    while (!stop_) {
+        int n = ::epoll_wait(epoll_fd_, events, 32, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            void* ptr = events[i].data.ptr;
+            if (ptr == &wake_fd_) return;
+            if (ptr == &listen_fd_) {
+                accept_all();
+                continue;
+            }
+            Connection& conn = *static_cast<Connection*>(ptr);
+            if (conn.fd < 0) continue;  // closed earlier in this batch
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close(conn);
+            } else if (events[i].events & EPOLLOUT) {
+                if (!flush(conn)) close(conn);
+            } else if (events[i].events & EPOLLIN) {
+                on_readable(conn);
+            }
+        }
+        connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+                                          [](const std::unique_ptr<Connection>& c) { return c->fd < 0; }),
+                           connections_.end());
+    }
+}
+
+void MetricsServer::accept_all() {
+    while (true) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN, or a connection that died before we got to it
+        if (connections_.size() >= kMaxConnections) {
+            ::close(fd);
+            continue;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = conn.get();
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            continue;
+        }
+        connections_.push_back(std::move(conn));
+    }
+}
+
+void MetricsServer::on_readable(Connection& conn) {
+    char buf[4096];
+    while (true) {
+        ssize_t n = ::recv(conn.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            conn.request.append(buf, static_cast<size_t>(n));
+            if (conn.request.size() > kMaxRequest) return close(conn);
+            continue;
+        }
+        if (n == 0) return close(conn);
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+        return close(conn);
+    }
+    if (conn.request.find("\r\n\r\n") == std::string::npos) return;
+
+    // Only the request line matters: "GET /metrics HTTP/1.1".
+    static const auto not_found = std::make_shared<const std::string>("not found\n");
+    static const auto not_allowed = std::make_shared<const std::string>("method not allowed\n");
+    const char* status = "200 OK";
+    const char* type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+    std::string_view line(conn.request.data(), conn.request.find("\r\n"));
+    if (line.rfind("GET ", 0) != 0) {
+        status = "405 Method Not Allowed";
+        type = "text/plain";
+        conn.body = not_allowed;
+    } else if (line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET /metrics?", 0) == 0 ||
+               line.rfind("GET / ", 0) == 0) {
+        conn.body = current_body();
+    } else {
+        status = "404 Not Found";
+        type = "text/plain";
+        conn.body = not_found;
+    }
+    conn.header.assign("HTTP/1.1 ").append(status).append("\r\nContent-Type: ").append(type);
+    conn.header.append("\r\nContent-Length: ").append(std::to_string(conn.body->size()));
+    conn.header.append("\r\nConnection: close\r\n\r\n");
+    conn.sent = 0;
+
+    if (!flush(conn)) return close(conn);
+    if (conn.fd < 0) return;
+    epoll_event ev{};
+    ev.events = EPOLLOUT;
+    ev.data.ptr = &conn;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+// Writes what's left of the response; closes the connection once it's all
+// out. False on a write error.
+bool MetricsServer::flush(Connection& conn) {
+    const size_t total = conn.header.size() + conn.body->size();
+    while (conn.sent < total) {
+        iovec iov[2];
+        int count = 0;
+        if (conn.sent < conn.header.size()) {
+            iov[count++] = {conn.header.data() + conn.sent, conn.header.size() - conn.sent};
+            iov[count++] = {const_cast<char*>(conn.body->data()), conn.body->size()};
+        } else {
+            size_t offset = conn.sent - conn.header.size();
+            iov[count++] = {const_cast<char*>(conn.body->data()) + offset, conn.body->size() - offset};
+        }
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = ::sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conn.sent += static_cast<size_t>(n);
+    }
+    close(conn);
+    return true;
+}
+
+void MetricsServer::close(Connection& conn) {
+    if (conn.fd < 0) return;
+    ::close(conn.fd);  // also drops it from the epoll set
+    conn.fd = -1;
+    conn.body.reset();
+}
+
+std::shared_ptr<const std::string> MetricsServer::current_body() {
+    static const SnapshotSet empty;
+    std::shared_ptr<const SnapshotSet> set = latest_ ? latest_() : nullptr;
+    const SnapshotSet& source = set ? *set : empty;
+    if (body_ && &source == body_set_ && source.version == body_version_) return body_;
+
+    // Reuse a buffer that neither body_ nor a connection still holds.
+    std::shared_ptr<std::string> buf;
+    for (auto& pooled : bodies_) {
+        if (pooled.use_count() == 1) {
+            buf = pooled;
+            break;
+        }
+    }
+    if (!buf) {
+        buf = std::make_shared<std::string>();
+        if (bodies_.size() < 4) bodies_.push_back(buf);
+    }
+    writer_.write(source, *buf);
+    body_ = buf;
+    body_set_ = &source;
+    body_version_ = source.version;
+    return body_;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "sampler.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Formats SnapshotSets as OpenMetrics text:
+//
+//   # TYPE kmap_thermal_temp gauge
+//   kmap_thermal_temp{device="thermal_zone0",path="/sys/class/thermal/thermal_zone0"} 45000
+//   kmap_cpu_util{device="cpu",path="...",channel="cpu3"} 120
+//   kmap_net_info{device="eth0",path="...",operstate="up",address="..."} 1
+//   # EOF
+//
+// Every number becomes a gauge family named after the driver and key, in
+// raw units; a key "<channel>.<metric>" (per-core CPU readings) is the
+// metric with a channel label. String values are labels of one _info
+// series per device. Families are interned, and the scratch and output
+// buffers kept, so formatting a set of the same shape again allocates
+// nothing. Not thread-safe.
+class OpenMetricsWriter {
+public:
+    void write(const SnapshotSet& set, std::string& out);
+
+private:
+    struct Sample {
+        std::string_view family;
+        uint32_t snap;   // index into set.devices
+        uint32_t value;  // index into its numbers, or ~0u for the _info series
+    };
+
+    std::vector<Sample> samples_;
+    std::string name_;  // family name being built
+};
+
+// HTTP endpoint (GET /metrics) on an epoll thread of its own. A scrape only
+// formats `latest()` when its version changed since the previous scrape;
+// otherwise the preformatted body is sent again. Scrapes never reach the
+// sampler, and any number of concurrent scrapers share one format per
+// published set. Bodies in flight are shared, refcounted buffers, recycled
+// once no connection is still sending them.
+class MetricsServer {
+public:
+    using Latest = std::function<std::shared_ptr<const SnapshotSet>()>;
+
+    MetricsServer(const std::string& address, Latest latest);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool ok() const { return listen_fd_ >= 0; }
+    const std::string& error() const { return error_; }
+
+private:
+    static constexpr size_t kMaxRequest = 8192;
+    static constexpr size_t kMaxConnections = 64;
+
+    struct Connection {
+        int fd = -1;
+        std::string request;
+        std::string header;
+        std::shared_ptr<const std::string> body;
+        size_t sent = 0;  // bytes of header + body written
+    };
+
+    void run();
+    void accept_all();
+    void on_readable(Connection& conn);
+    bool flush(Connection& conn);
+    void close(Connection& conn);
+    std::shared_ptr<const std::string> current_body();
+
+    Latest latest_;
+    std::string error_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd, for shutdown
+    std::atomic<bool> stop_{false};
+
+    // Server thread only.
+    std::vector<std::unique_ptr<Connection>> connections_;
+    OpenMetricsWriter writer_;
+    std::vector<std::shared_ptr<std::string>> bodies_;  // pool, see current_body()
+    std::shared_ptr<const std::string> body_;
+    const SnapshotSet* body_set_ = nullptr;
+    uint64_t body_version_ = 0;
+
+    std::thread thread_;
+};
@@ -0,0 +1,170 @@
+#include "options.hpp"
+
+#include <cstdlib>
+
+// Accepts "250", "250ms" or "2s"; returns 0 on malformed input.
+static long parse_interval_ms(const std::string& arg) {
+    char* end = nullptr;
+    long value = std::strtol(arg.c_str(), &end, 10);
+    if (end == arg.c_str()) return 0;
+    std::string unit(end);
+    if (unit.empty() || unit == "ms") return value;
+    if (unit == "s") return value * 1000;
+    return 0;
+}
+
+// Accepts "0.5%" or "0.5" (percent of one core); returns a negative value
+// on malformed input.
+static double parse_percent(const std::string& arg) {
+    char* end = nullptr;
+    double value = std::strtod(arg.c_str(), &end);
+    if (end == arg.c_str()) return -1;
+    std::string unit(end);
+    if (!unit.empty() && unit != "%") return -1;
+    return value;
+}
+
+static std::vector<std::string> split(const std::string& list, char sep) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(sep, start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start) parts.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+static bool take_value(const std::string& arg, const char* flag, std::string& value) {
+    std::string prefix = std::string(flag) + "=";
+    if (arg.rfind(prefix, 0) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+bool parse_options(int argc, char** argv, Options& opts, std::string& error) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+
+        if (arg == "-h" || arg == "--help") {
+            opts.help = true;
+        } else if (arg == "--headless") {
+            opts.headless = true;
+        } else if (arg == "--startup-trace") {
+            opts.startup_trace = true;
+        } else if (take_value(arg, "--interval", value)) {
+            long ms = parse_interval_ms(value);
+            if (ms <= 0) {
+                error = "invalid interval: " + value;
+                return false;
+            }
+            opts.interval = std::chrono::milliseconds(ms);
+        } else if (take_value(arg, "--max-fps", value)) {
+            opts.max_fps = static_cast<int>(std::strtol(value.c_str(), nullptr, 10));
+            if (opts.max_fps <= 0) {
+                error = "invalid max fps: " + value;
+                return false;
+            }
+        } else if (take_value(arg, "--sampler-threads", value)) {
+            long threads = std::strtol(value.c_str(), nullptr, 10);
+            if (threads <= 0 || threads > 64) {
+                error = "invalid sampler thread count: " + value;
+                return false;
+            }
+            opts.sampler_threads = static_cast<unsigned>(threads);
+        } else if (take_value(arg, "--max-cpu", value)) {
+            double percent = parse_percent(value);
+            if (!(percent > 0 && percent <= 6400)) {
+                error = "invalid CPU budget: " + value;
+                return false;
+            }
+            opts.max_cpu = percent / 100;
+        } else if (take_value(arg, "--idle-after", value)) {
+            long ms = parse_interval_ms(value);
+            if (ms < 0 || (ms == 0 && value[0] != '0')) {
+                error = "invalid idle timeout: " + value;
+                return false;
+            }
+            opts.idle_after = std::chrono::milliseconds(ms);
+        } else if (take_value(arg, "--categories", value)) {
+            opts.categories = split(value, ',');
+        } else if (take_value(arg, "--record", value)) {
+            opts.record = value;
+        } else if (take_value(arg, "--record-size", value)) {
+            opts.record_size_mb = std::strtol(value.c_str(), nullptr, 10);
+            if (opts.record_size_mb < 16) {
+                error = "invalid recording size (MiB, at least 16): " + value;
+                return false;
+            }
+        } else if (take_value(arg, "--replay", value)) {
+            opts.replay = value;
+        } else if (arg == "--metrics-listen") {
+            opts.metrics_listen = ":9477";
+        } else if (take_value(arg, "--metrics-listen", value)) {
+            opts.metrics_listen = value;
+        } else if (take_value(arg, "--listen", value)) {
+            opts.listen = value;
+        } else if (take_value(arg, "--connect", value)) {
+            opts.connect = split(value, ',');
+            if (opts.connect.empty()) {
+                error = "no address given to --connect";
+                return false;
+            }
+        } else if (take_value(arg, "--alerts", value)) {
+            opts.alerts = value;
+        } else if (take_value(arg, "--alert-hook", value)) {
+            opts.alert_hook = value;
+        } else if (take_value(arg, "--sysfs-root", value)) {
+            opts.sysfs_root = value;
+        } else if (arg == "--synthetic") {
+            opts.synthetic = true;
+        } else if (take_value(arg, "--synthetic", value)) {
+            opts.synthetic = true;
+            opts.synthetic_spec = value;
+        } else if (take_value(arg, "--format", value)) {
+            if (value == "ndjson") {
+                opts.format = OutputFormat::Ndjson;
+            } else if (value == "binary") {
+                opts.format = OutputFormat::Binary;
+            } else {
+                error = "unknown format: " + value;
+                return false;
+            }
+        } else if (take_value(arg, "--output", value)) {
+            opts.output = value;
+        } else if (take_value(arg, "--samples", value)) {
+            opts.samples = std::strtol(value.c_str(), nullptr, 10);
+        } else {
+            error = "unknown argument: " + arg;
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* usage() {
+    return "usage: kmap [options]\n"
+           "  --interval=<n>[ms|s]      sampler poll interval (default 500ms)\n"
+           "  --max-fps=<n>             cap on background-triggered redraws (default 30)\n"
+           "  --sampler-threads=<n>     background sampling threads (default: cores, max 4)\n"
+           "  --max-cpu=<n>%            CPU budget; stretches the poll interval to stay within it\n"
+           "  --idle-after=<n>[ms|s]    sample every 10s after this long without input (default 60s, 0 never)\n"
+           "  --headless                stream samples without the TUI\n"
+           "  --categories=<id,...>     headless, kmapd: thermal,hwmon,net,power,rapl,leds,cpu (default all)\n"
+           "  --format=ndjson|binary    headless: output encoding (default ndjson)\n"
+           "  --output=<file>           headless: write to file instead of stdout\n"
+           "  --samples=<n>             headless: stop after n ticks\n"
+           "  --record=<file>           sample like --headless into a recording file\n"
+           "  --record-size=<MiB>       recording: preallocated file size (default 256)\n"
+           "  --replay=<file>           play a recording back in the TUI\n"
+           "  --alerts=<file>           alert rules (default ~/.config/kmap/alerts if present)\n"
+           "  --alert-hook=<cmd>        run a shell command for every alert raised or cleared\n"
+           "  --connect=<addr,...>      show devices of remote kmapd daemons instead of this host\n"
+           "  --listen=<addr>           kmapd: host:port or unix socket path (default 127.0.0.1:9476)\n"
+           "  --metrics-listen[=<addr>] serve every device as OpenMetrics on GET /metrics (default :9477)\n"
+           "  --sysfs-root=<dir>        read devices from <dir> in place of /sys (e.g. a copied tree)\n"
+           "  --synthetic[=<spec>]      simulated devices, e.g. net=10000,thermal=50,hwmon=20x25,churn=30%\n"
+           "  --startup-trace           print time to first frame and to fully populated on exit\n";
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+enum class OutputFormat { Ndjson, Binary };
+
+struct Options {
+    std::chrono::milliseconds interval{500};
+    int max_fps = 30;
+    unsigned sampler_threads = 0;         // 0 picks one per core, up to 4
+
+    // Headless mode: stream samples instead of running the TUI.
+    bool headless = false;
+    std::vector<std::string> categories;  // Category ids; empty selects all
+    OutputFormat format = OutputFormat::Ndjson;
+    std::string output;                   // empty writes to stdout
+    long samples = 0;                     // stop after this many ticks; 0 runs forever
+
+    // Recording: --record samples like headless into a file; --replay plays
+    // one back in the TUI.
+    std::string record;
+    long record_size_mb = 256;
+    std::string replay;
+
+    // Remote mode: kmapd serves on `listen`; the TUI attaches to `connect`.
+    std::string listen = "127.0.0.1:9476";
+    std::vector<std::string> connect;
+
+    // OpenMetrics endpoint; empty serves none.
+    std::string metrics_listen;
+
+    // Alert rules (see alerts.hpp); empty looks for the default rule file.
+    std::string alerts;
+    std::string alert_hook;               // shell command run per alert event
+
+    // Low-overhead mode: a CPU budget in cores (0.005 for 0.5%; 0 for none),
+    // and idle sampling after this long without input (0 never).
+    double max_cpu = 0;
+    std::chrono::milliseconds idle_after{60000};
+
+    // Attribute backend (see backend.hpp): a directory standing in for /sys,
+    // or a synthetic device tree built from a spec (empty for the defaults).
+    std::string sysfs_root;
+    bool synthetic = false;
+    std::string synthetic_spec;
+
+    // Report time to first frame and to a fully populated UI on exit.
+    bool startup_trace = false;
+
+    bool help = false;
+};
+
+// Returns false and fills `error` on a malformed argument.
+bool parse_options(int argc, char** argv, Options& opts, std::string& error);
+
+const char* usage();
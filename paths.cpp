@@ -0,0 +1,80 @@
+#include "paths.hpp"
+
+#include <cstring>
+#include <mutex>
+
+std::string_view StringArena::store(std::string_view s) {
+    const size_t need = s.size() + 1;
+    char* dst;
+    if (need > kChunkSize) {
+        // Never a sysfs name (PATH_MAX is 4096), but still correct: it gets
+        // a chunk of its own and the next string starts a fresh one.
+        chunks_.push_back(std::make_unique<char[]>(need));
+        bytes_ += need;
+        used_ = kChunkSize;
+        dst = chunks_.back().get();
+    } else {
+        if (kChunkSize - used_ < need) {
+            chunks_.push_back(std::make_unique<char[]>(kChunkSize));
+            bytes_ += kChunkSize;
+            used_ = 0;
+        }
+        dst = chunks_.back().get() + used_;
+        used_ += need;
+    }
+    std::memcpy(dst, s.data(), s.size());
+    dst[s.size()] = '\0';
+    return std::string_view(dst, s.size());
+}
+
+void StringArena::clear() {
+    chunks_.clear();
+    bytes_ = 0;
+    used_ = kChunkSize;
+}
+
+std::string_view NameArena::intern(std::string_view name) {
+    auto it = names_.find(name);
+    if (it != names_.end()) return *it;
+    return *names_.insert(arena_.store(name)).first;
+}
+
+void NameArena::clear() {
+    names_.clear();
+    arena_.clear();
+}
+
+PathTable::PathTable() {
+    strings_.push_back(arena_.store(""));
+    ids_.emplace(strings_.back(), kEmpty);
+}
+
+PathId PathTable::intern(std::string_view s) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(s);
+        if (it != ids_.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(s);
+    if (it != ids_.end()) return it->second;
+    PathId id = static_cast<PathId>(strings_.size());
+    strings_.push_back(arena_.store(s));
+    ids_.emplace(strings_.back(), id);
+    return id;
+}
+
+std::string_view PathTable::str(PathId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return id < strings_.size() ? strings_[id] : strings_[kEmpty];
+}
+
+size_t PathTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return strings_.size();
+}
+
+PathTable& paths() {
+    static PathTable table;
+    return table;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Append-only, chunked string storage. Stored strings are NUL-terminated
+// and never move, so views into them stay valid until clear().
+class StringArena {
+public:
+    std::string_view store(std::string_view s);
+    void clear();
+
+    size_t bytes() const { return bytes_; }
+
+private:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    size_t used_ = kChunkSize;  // bytes taken in the last chunk
+    size_t bytes_ = 0;
+};
+
+// A StringArena that stores each distinct name once, so hotplug churn of
+// the same interfaces doesn't grow it. Not thread-safe.
+class NameArena {
+public:
+    std::string_view intern(std::string_view name);
+    void clear();
+
+    size_t bytes() const { return arena_.bytes(); }
+
+private:
+    StringArena arena_;
+    std::unordered_set<std::string_view> names_;
+};
+
+// Small integer handle for an interned path, attribute name or snapshot key.
+using PathId = uint32_t;
+
+// Process-wide registry of long-lived strings: the snapshot keys drivers
+// and decoders publish (through key()), and the device paths alert slots
+// and events refer to by PathId. Each string is stored once for the life of
+// the process, so handles and views never dangle. Samplers, driver state
+// and history still key devices by their std::string path, looked up once
+// per device each pass rather than per attribute read. Thread-safe; lookups
+// of known strings only take a shared lock.
+class PathTable {
+public:
+    static constexpr PathId kEmpty = 0;  // ""
+
+    PathTable();
+
+    PathId intern(std::string_view s);
+
+    std::string_view str(PathId id) const;
+    const char* c_str(PathId id) const { return str(id).data(); }
+
+    // The interned copy of `s`, for use as a long-lived key.
+    std::string_view key(std::string_view s) { return str(intern(s)); }
+
+    size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    StringArena arena_;
+    std::vector<std::string_view> strings_;  // indexed by PathId
+    std::unordered_map<std::string_view, PathId> ids_;
+};
+
+PathTable& paths();
@@ -0,0 +1,127 @@
+#include "profile.hpp"
+
+#include "rates.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+size_t LatencyHistogram::bucket(uint64_t ns) {
+    if (ns < static_cast<uint64_t>(kSub)) return static_cast<size_t>(ns);
+    int msb = 63 - __builtin_clzll(ns);
+    if (msb > kMaxBit) return kBuckets - 1;
+    size_t group = static_cast<size_t>(msb - kSubBits + 1);
+    size_t sub = static_cast<size_t>((ns >> (msb - kSubBits)) - kSub);
+    return group * kSub + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t index) {
+    if (index < static_cast<size_t>(kSub)) return index;
+    size_t group = index / kSub;
+    size_t sub = index % kSub;
+    int shift = static_cast<int>(group) - 1;
+    return ((kSub + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    if (ns < 0) ns = 0;
+    counts_[bucket(static_cast<uint64_t>(ns))].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t seen = max_.load(std::memory_order_relaxed);
+    while (ns > seen && !max_.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+    }
+}
+
+int64_t LatencyHistogram::percentile(double p) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p * total));
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            int64_t upper = static_cast<int64_t>(bucket_upper(i));
+            int64_t highest = max();
+            return upper < highest ? upper : highest;
+        }
+    }
+    return max();
+}
+
+LatencyHistogram* Profiler::histogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(name);
+    if (it != index_.end()) return it->second;
+    LatencyHistogram* h = &storage_.emplace_back();
+    index_.emplace(name, h);
+    return h;
+}
+
+LatencyHistogram* Profiler::histogram(const std::string& name, size_t limit, const std::string& overflow) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(name);
+    if (it == index_.end() && index_.size() >= limit) it = index_.find(overflow);
+    if (it != index_.end()) return it->second;
+    LatencyHistogram* h = &storage_.emplace_back();
+    index_.emplace(index_.size() >= limit ? overflow : name, h);
+    return h;
+}
+
+std::vector<Profiler::Entry> Profiler::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> out;
+    out.reserve(index_.size());
+    for (const auto& kv : index_) out.push_back({kv.first, kv.second});
+    return out;
+}
+
+Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+ScopedTimer::ScopedTimer(LatencyHistogram* histogram)
+    : histogram_(histogram), start_ns_(histogram ? monotonic_ns() : 0) {}
+
+ScopedTimer::~ScopedTimer() {
+    if (histogram_) histogram_->record(monotonic_ns() - start_ns_);
+}
+
+int64_t process_cpu_ns() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+int64_t CpuBudget::period(int64_t base_ns) {
+    int64_t cpu = process_cpu_ns();
+    int64_t now = monotonic_ns();
+    if (last_cpu_ns_ >= 0 && now > last_ns_) {
+        double spent = static_cast<double>(cpu - last_cpu_ns_);
+        cycle_cpu_ns_ += kSmoothing * (spent - cycle_cpu_ns_);
+        usage_ += kSmoothing * (spent / static_cast<double>(now - last_ns_) - usage_);
+    }
+    last_cpu_ns_ = cpu;
+    last_ns_ = now;
+    if (cores_ <= 0) return base_ns;
+    int64_t needed = static_cast<int64_t>(cycle_cpu_ns_ / cores_);
+    return std::clamp(needed, base_ns, std::max(base_ns, kMaxPeriodNs));
+}
+
+std::string format_latency(int64_t ns) {
+    char buf[24];
+    if (ns < 1000) {
+        std::snprintf(buf, sizeof(buf), "%lldns", static_cast<long long>(ns));
+    } else if (ns < 1000000) {
+        std::snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    } else if (ns < 1000000000) {
+        std::snprintf(buf, sizeof(buf), "%.1fms", ns / 1e6);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.2fs", ns / 1e9);
+    }
+    return buf;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Log-linear latency histogram in the spirit of HdrHistogram: 8 sub-buckets
+// per power of two (~12% resolution), from 1 ns up to ~4.9 hours. record()
+// is a couple of relaxed atomic adds, so any thread can record into it
+// without locks while another reads percentiles.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 3;
+    static constexpr int kSub = 1 << kSubBits;
+    static constexpr int kMaxBit = 43;
+    static constexpr size_t kBuckets = (kMaxBit - kSubBits + 2) * kSub;
+
+    void record(int64_t ns);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    int64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // Upper edge of the bucket holding the p-th quantile (p in [0, 1]).
+    int64_t percentile(double p) const;
+
+private:
+    static size_t bucket(uint64_t ns);
+    static uint64_t bucket_upper(size_t index);
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> max_{0};
+};
+
+// Process-wide set of named histograms. Registration takes a lock (it
+// happens once per name); recording into a returned histogram never does.
+class Profiler {
+public:
+    struct Entry {
+        std::string name;
+        const LatencyHistogram* histogram;
+    };
+
+    // Returned pointers stay valid for the life of the process.
+    LatencyHistogram* histogram(const std::string& name);
+    // The same, but once `limit` names are registered, new names get the
+    // shared `overflow` histogram instead of their own.
+    LatencyHistogram* histogram(const std::string& name, size_t limit, const std::string& overflow);
+
+    std::vector<Entry> entries() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<LatencyHistogram> storage_;
+    std::map<std::string, LatencyHistogram*> index_;
+};
+
+Profiler& profiler();
+
+// Records the lifetime of the scope into a histogram (no-op for nullptr).
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram* histogram);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    LatencyHistogram* histogram_;
+    int64_t start_ns_;
+};
+
+// Keeps a periodic loop within a share of one core (--max-cpu), charging it
+// with all of the process's CPU time, as a cgroup's cpu.max would: the
+// interval is stretched to the smoothed CPU time of one cycle divided by
+// the budget, up to kMaxPeriodNs. Measured with CLOCK_PROCESS_CPUTIME_ID, so
+// drawing the frames a pass triggers counts against it too. Not
+// thread-safe; one loop calls period() once per cycle.
+class CpuBudget {
+public:
+    static constexpr int64_t kMaxPeriodNs = 30000000000;
+
+    // `cores` of 0 disables the budget; 0.005 is --max-cpu=0.5%.
+    explicit CpuBudget(double cores = 0) : cores_(cores) {}
+    void set(double cores) { cores_ = cores; }
+
+    // How long until the next cycle: `base_ns`, or longer if the cycles so
+    // far cost more than the budget allows at that rate.
+    int64_t period(int64_t base_ns);
+    // Smoothed CPU time per cycle, and the cores it averaged.
+    int64_t cycle_cpu_ns() const { return static_cast<int64_t>(cycle_cpu_ns_); }
+    double usage() const { return usage_; }
+
+private:
+    static constexpr double kSmoothing = 0.3;
+
+    double cores_;
+    int64_t last_cpu_ns_ = -1;
+    int64_t last_ns_ = 0;
+    double cycle_cpu_ns_ = 0;
+    double usage_ = 0;
+};
+
+// Process CPU time so far, in ns.
+int64_t process_cpu_ns();
+
+// "850ns", "12.3us", "4.1ms", "1.20s".
+std::string format_latency(int64_t ns);
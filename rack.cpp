@@ -0,0 +1,116 @@
+#include "rack.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+
+static constexpr size_t kPoolColumns = 3;
+
+// Indexed by RackStore::Key.
+static constexpr std::string_view kKeyNames[] = {"temp", "rx_bytes/s", "tx_bytes/s", "util"};
+
+void top_hosts(const RackColumns& rack, RackColumns::Metric metric, size_t k, std::vector<uint32_t>& order) {
+    const std::vector<int64_t>& column = rack.columns[metric];
+    order.clear();
+    for (size_t i = 0; i < column.size(); ++i) {
+        if (column[i] != RackColumns::kMissing) order.push_back(static_cast<uint32_t>(i));
+    }
+    size_t top = std::min(order.size(), k);
+    // Ties go to the lower index, so equal hosts don't swap places between
+    // frames.
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), [&](uint32_t a, uint32_t b) {
+        return column[a] != column[b] ? column[a] > column[b] : a < b;
+    });
+    order.resize(top);
+}
+
+RackStore::RackStore(std::vector<std::string> hosts) : keys_(hosts.size()) {
+    live_.connected.assign(hosts.size(), 0);
+    for (auto& column : live_.columns) column.assign(hosts.size(), RackColumns::kMissing);
+    live_.hosts = std::make_shared<const std::vector<std::string>>(std::move(hosts));
+    for (auto& keys : keys_) keys.ids.fill(kNoKey);
+}
+
+void RackStore::resolve(HostKeys& keys, const DeltaDecoder& decoder) {
+    const auto& names = decoder.keys();
+    for (; keys.scanned < names.size(); ++keys.scanned) {
+        for (size_t k = 0; k < kKeyCount; ++k) {
+            if (names[keys.scanned] == kKeyNames[k]) keys.ids[k] = static_cast<uint32_t>(keys.scanned);
+        }
+    }
+}
+
+void RackStore::update(size_t host, const DeltaDecoder& decoder) {
+    HostKeys& keys = keys_[host];
+    resolve(keys, decoder);
+
+    auto number = [&](const WireDevice& dev, Key key, int64_t& out) {
+        if (keys.ids[key] == kNoKey) return false;
+        auto it = dev.numbers.find(keys.ids[key]);
+        if (it == dev.numbers.end()) return false;
+        out = it->second;
+        return true;
+    };
+
+    int64_t temp = RackColumns::kMissing;
+    int64_t net = RackColumns::kMissing;
+    int64_t cpu = RackColumns::kMissing;
+    for (const auto& entry : decoder.devices()) {
+        const WireDevice& dev = entry.second;
+        int64_t value = 0;
+        if (dev.driver == "thermal") {
+            if (number(dev, kTempKey, value)) temp = std::max(temp, value);
+        } else if (dev.driver == "net") {
+            // Loopback traffic says nothing about how busy the host's links are.
+            if (dev.path.size() >= 3 && dev.path.compare(dev.path.size() - 3, 3, "/lo") == 0) continue;
+            int64_t rx = 0, tx = 0;
+            bool has_rx = number(dev, kRxKey, rx);
+            bool has_tx = number(dev, kTxKey, tx);
+            if (!has_rx && !has_tx) continue;
+            net = (net == RackColumns::kMissing ? 0 : net) + rx + tx;
+        } else if (dev.driver == "cpu") {
+            if (number(dev, kUtilKey, value)) cpu = std::max(cpu, value);
+        }
+    }
+
+    int64_t* row[] = {&live_.columns[RackColumns::kTemp][host], &live_.columns[RackColumns::kNet][host],
+                      &live_.columns[RackColumns::kCpu][host]};
+    int64_t values[] = {temp, net, cpu};
+    for (size_t m = 0; m < RackColumns::kMetricCount; ++m) {
+        changed_ |= *row[m] != values[m];
+        *row[m] = values[m];
+    }
+    changed_ |= !live_.connected[host];
+    live_.connected[host] = 1;
+}
+
+void RackStore::disconnect(size_t host) {
+    keys_[host].scanned = 0;
+    keys_[host].ids.fill(kNoKey);
+    live_.connected[host] = 0;
+    for (auto& column : live_.columns) column[host] = RackColumns::kMissing;
+    changed_ = true;
+}
+
+void RackStore::publish() {
+    if (!changed_) return;
+    changed_ = false;
+    ++live_.version;
+
+    std::shared_ptr<RackColumns> out;
+    for (auto& pooled : pool_) {
+        if (pooled.use_count() == 1) {
+            // Pairs with the release of the last reader letting go of it.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            out = pooled;
+            break;
+        }
+    }
+    if (!out) {
+        out = std::make_shared<RackColumns>();
+        if (pool_.size() < kPoolColumns) pool_.push_back(out);
+    }
+    // Same sizes every time, so the copies reuse the buffers.
+    *out = live_;
+    std::atomic_store(&published_, std::shared_ptr<const RackColumns>(std::move(out)));
+}
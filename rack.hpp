@@ -0,0 +1,73 @@
+#pragma once
+
+#include "wire.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Per-host rollups of a remote source with many agents, stored by column:
+// one contiguous array per metric, indexed by host, so ranking a rack by
+// any metric walks a single array of integers instead of every host's
+// devices and maps.
+struct RackColumns {
+    enum Metric : size_t {
+        kTemp,  // hottest thermal zone, m°C
+        kNet,   // rx + tx over every interface but lo, bytes/s
+        kCpu,   // overall load, per mille
+        kMetricCount,
+    };
+    static constexpr int64_t kMissing = std::numeric_limits<int64_t>::min();
+
+    std::shared_ptr<const std::vector<std::string>> hosts;  // labels; fixed for the source's lifetime
+    std::vector<uint8_t> connected;
+    std::array<std::vector<int64_t>, kMetricCount> columns;  // kMissing where a host has no reading
+    uint64_t version = 0;
+
+    size_t size() const { return connected.size(); }
+};
+
+// The `k` hosts with the highest `metric`, highest first, into `order`
+// (reused). Hosts without a reading are left out. A partial sort: the cost
+// is linear in the host count for a fixed `k`.
+void top_hosts(const RackColumns& rack, RackColumns::Metric metric, size_t k, std::vector<uint32_t>& order);
+
+// Keeps the columns up to date on the client thread. A host's row is
+// recomputed from its own decoder after each of its frames, so a frame costs
+// what that host sent, whatever the number of hosts; publish() copies the
+// columns into a recycled buffer for the UI.
+class RackStore {
+public:
+    explicit RackStore(std::vector<std::string> hosts);
+
+    void update(size_t host, const DeltaDecoder& decoder);
+    // The host's row reads missing until it is updated again, and its key
+    // ids are resolved afresh (a new stream numbers keys from zero).
+    void disconnect(size_t host);
+
+    void publish();
+    std::shared_ptr<const RackColumns> latest() const { return std::atomic_load(&published_); }
+
+private:
+    // Wire keys the rollups read.
+    enum Key : size_t { kTempKey, kRxKey, kTxKey, kUtilKey, kKeyCount };
+    static constexpr uint32_t kNoKey = ~0u;
+
+    struct HostKeys {
+        size_t scanned = 0;  // decoder keys looked at so far; ids only get appended
+        std::array<uint32_t, kKeyCount> ids;
+    };
+
+    void resolve(HostKeys& keys, const DeltaDecoder& decoder);
+
+    RackColumns live_;
+    std::vector<HostKeys> keys_;
+    bool changed_ = true;
+
+    std::shared_ptr<const RackColumns> published_;
+    std::vector<std::shared_ptr<RackColumns>> pool_;
+};
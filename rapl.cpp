@@ -0,0 +1,109 @@
+#include "rapl.hpp"
+
+#include "backend.hpp"
+#include "units.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+static bool read_u64_at(int fd, uint64_t& out) {
+    char buf[32];
+    ssize_t n = attr_backend().pread(fd, buf, sizeof(buf));
+    return n > 0 && parse_u64(std::string_view(buf, static_cast<size_t>(n)), out);
+}
+
+RaplPoller::~RaplPoller() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    for (auto& zone : zones_) attr_backend().close(zone.fd);
+}
+
+RaplPoller::Zone* RaplPoller::watch(const std::string& zone) {
+    int fd = attr_backend().open(zone + "/energy_uj");
+    if (fd < 0) return nullptr;
+    uint64_t value = 0;
+    if (!read_u64_at(fd, value)) {
+        attr_backend().close(fd);
+        return nullptr;
+    }
+    uint64_t range = 0;
+    int range_fd = attr_backend().open(zone + "/max_energy_range_uj");
+    if (range_fd >= 0) {
+        read_u64_at(range_fd, range);
+        attr_backend().close(range_fd);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Zone& z = zones_.emplace_back();
+    z.path = zone;
+    z.fd = fd;
+    z.range = range;
+    z.taken_ns = monotonic_ns();
+    z.polled_ns = z.taken_ns;
+    z.meter.add_counter(value, range, z.taken_ns);
+    if (!thread_.joinable()) thread_ = std::thread(&RaplPoller::run, this);
+    return &z;
+}
+
+void RaplPoller::unwatch(const std::string& zone) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = zones_.begin(); it != zones_.end(); ++it) {
+        if (it->path != zone) continue;
+        attr_backend().close(it->fd);
+        zones_.erase(it);
+        return;
+    }
+}
+
+// A read less than half a period after the previous one would make a
+// meaningless peak out of the counter's own update granularity.
+void RaplPoller::poll(Zone& zone, int64_t now_ns) {
+    if (now_ns - zone.polled_ns < 500000000 / kRateHz) return;
+    zone.polled_ns = now_ns;
+    uint64_t value = 0;
+    if (!read_u64_at(zone.fd, value)) return;
+    zone.meter.add_counter(value, zone.range, now_ns);
+    int64_t power = 0;
+    if (zone.meter.power(power)) zone.peak_uw = std::max(zone.peak_uw, power);
+}
+
+void RaplPoller::take(Zone* zone, int64_t now_ns, Reading& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Zone& z = *zone;
+    poll(z, now_ns);
+
+    // Timed by the read the energy came from, not by now.
+    out = Reading{};
+    out.energy_uj = z.meter.energy_uj();
+    int64_t dt_ns = z.polled_ns - z.taken_ns;
+    out.ready = z.meter.average(out.average_uw) && dt_ns > 0;
+    if (out.ready) {
+        out.power_uw = static_cast<int64_t>(static_cast<double>(out.energy_uj - z.taken_uj) * 1e9 / dt_ns);
+        out.peak_uw = std::max(z.peak_uw, out.power_uw);
+    }
+    z.taken_ns = z.polled_ns;
+    z.taken_uj = out.energy_uj;
+    z.peak_uw = 0;
+}
+
+void RaplPoller::run() {
+    const auto period = std::chrono::microseconds(1000000 / kRateHz);
+    auto next = std::chrono::steady_clock::now() + period;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        wake_.wait_until(lock, next, [this] { return stop_; });
+        if (stop_) return;
+        int64_t now = monotonic_ns();
+        for (auto& zone : zones_) {
+            if (now - zone.taken_ns <= kIdleNs) poll(zone, now);
+        }
+        // Fixed-rate ticks; after a stall (suspend), resume from now.
+        next += period;
+        auto current = std::chrono::steady_clock::now();
+        if (next < current) next = current + period;
+    }
+}
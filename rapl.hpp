@@ -0,0 +1,69 @@
+#pragma once
+
+#include "rates.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Reads the energy counters of RAPL zones (/sys/class/powercap/intel-rapl:*)
+// at kRateHz on a thread of its own, so power bursts shorter than the
+// sampler interval still show up in a zone's peak. The counter is
+// cumulative, so energy and averages are exact at any rate; only the peak
+// needs the fast poll. A zone nobody has taken readings from for kIdleNs
+// stops being polled until the next take(), whose own read then covers the
+// gap, so a zone that isn't on screen costs nothing.
+class RaplPoller {
+public:
+    static constexpr int kRateHz = 50;
+    static constexpr int64_t kIdleNs = 2000000000;
+
+    // Owned by the poller and only touched under its lock.
+    struct Zone {
+        std::string path;
+        int fd = -1;
+        uint64_t range = 0;  // max_energy_range_uj
+        EnergyMeter meter;   // every poll
+        int64_t polled_ns = 0;
+        int64_t taken_ns = 0;
+        int64_t taken_uj = 0;  // meter.energy_uj() at the previous take()
+        int64_t peak_uw = 0;
+    };
+
+    struct Reading {
+        int64_t energy_uj = 0;   // since the zone was first watched
+        int64_t power_uw = 0;    // since the previous take()
+        int64_t peak_uw = 0;     // highest poll-to-poll power since the previous take()
+        int64_t average_uw = 0;  // EnergyMeter::kWindowNs rolling average
+        bool ready = false;      // two reads apart; the fields above are valid
+    };
+
+    RaplPoller() = default;
+    ~RaplPoller();
+
+    RaplPoller(const RaplPoller&) = delete;
+    RaplPoller& operator=(const RaplPoller&) = delete;
+
+    // Starts polling <zone>/energy_uj; nullptr if it can't be read (since
+    // Linux 5.10 it is root-only by default). Handles stay valid until
+    // unwatch().
+    Zone* watch(const std::string& zone);
+    void unwatch(const std::string& zone);
+
+    // Reads the counter once more (unless the poller just did) and takes
+    // the zone's readings.
+    void take(Zone* zone, int64_t now_ns, Reading& out);
+
+private:
+    void run();
+    static void poll(Zone& zone, int64_t now_ns);
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::list<Zone> zones_;  // stable addresses
+    bool stop_ = false;
+    std::thread thread_;  // started by the first watch()
+};
@@ -0,0 +1,134 @@
+#include "rates.hpp"
+
+#include <cmath>
+#include <ctime>
+
+int64_t monotonic_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t counter_delta(uint64_t prev, uint64_t cur, bool& reset) {
+    reset = false;
+    if (cur >= prev) return cur - prev;
+    if (prev <= UINT32_MAX) {
+        uint64_t wrapped = (static_cast<uint64_t>(UINT32_MAX) - prev) + cur + 1;
+        // More than half the range between two polls is far likelier to be a
+        // reset of a small counter than a genuine wrap.
+        if (wrapped <= (UINT32_MAX >> 1)) return wrapped;
+    }
+    reset = true;
+    return 0;
+}
+
+bool RateMeter::update(uint64_t value, int64_t now_ns, bool fresh) {
+    if (!fresh) {
+        if (ready_ && now_ns > decay_ns_) {
+            rate_ *= std::exp(-((now_ns - decay_ns_) / 1e9) / tau_);
+            decay_ns_ = now_ns;
+        }
+        return ready_;
+    }
+    if (!primed_) {
+        value_ = value;
+        stamp_ns_ = now_ns;
+        decay_ns_ = now_ns;
+        primed_ = true;
+        return false;
+    }
+
+    int64_t dt_ns = now_ns - stamp_ns_;
+    if (dt_ns <= 0) return ready_;
+
+    bool reset = false;
+    uint64_t delta = counter_delta(value_, value, reset);
+    value_ = value;
+    stamp_ns_ = now_ns;
+    decay_ns_ = now_ns;
+    if (reset) return ready_;
+
+    double dt = dt_ns / 1e9;
+    double instant = delta / dt;
+    if (!ready_) {
+        rate_ = instant;
+        ready_ = true;
+    } else {
+        // Time-based alpha so smoothing doesn't depend on the poll interval.
+        double alpha = 1.0 - std::exp(-dt / tau_);
+        rate_ += alpha * (instant - rate_);
+    }
+    return true;
+}
+
+void EnergyMeter::add_power(int64_t microwatts, int64_t now_ns) {
+    if (!primed_ || now_ns - stamp_ns_ > kMaxGapNs) {
+        power_uw_ = microwatts;
+        stamp_ns_ = now_ns;
+        primed_ = true;
+        count_ = 0;
+        advance(0, now_ns);
+        return;
+    }
+    // Whole microseconds only, so the next interval picks up the rest.
+    int64_t dt_us = (now_ns - stamp_ns_) / 1000;
+    if (dt_us <= 0) return;
+    stamp_ns_ += dt_us * 1000;
+    remainder_ += power_uw_ * dt_us;
+    int64_t added = remainder_ / 1000000;
+    remainder_ -= added * 1000000;
+    power_uw_ = microwatts;
+    ready_ = true;
+    advance(added, now_ns);
+}
+
+void EnergyMeter::add_counter(uint64_t microjoules, uint64_t range, int64_t now_ns) {
+    if (!primed_ || now_ns - stamp_ns_ > kMaxGapNs) {
+        counter_ = microjoules;
+        stamp_ns_ = now_ns;
+        primed_ = true;
+        count_ = 0;
+        advance(0, now_ns);
+        return;
+    }
+    int64_t dt_ns = now_ns - stamp_ns_;
+    if (dt_ns <= 0) return;
+    uint64_t delta;
+    if (microjoules >= counter_) {
+        delta = microjoules - counter_;
+    } else if (range > counter_ && (range - counter_) + microjoules <= range / 2) {
+        delta = (range - counter_) + microjoules;
+    } else {
+        // More than half the range between two reads is likelier a reset.
+        delta = 0;
+    }
+    counter_ = microjoules;
+    stamp_ns_ = now_ns;
+    power_uw_ = static_cast<int64_t>(static_cast<double>(delta) * 1e9 / dt_ns);
+    ready_ = true;
+    advance(static_cast<int64_t>(delta), now_ns);
+}
+
+void EnergyMeter::advance(int64_t added_uj, int64_t now_ns) {
+    energy_uj_ += added_uj;
+    last_ns_ = now_ns;
+    if (count_ && now_ns - window_[head_].ns < kWindowNs / kSlots) return;
+    head_ = (head_ + 1) % kSlots;
+    window_[head_] = {now_ns, energy_uj_};
+    if (count_ < kSlots) ++count_;
+}
+
+bool EnergyMeter::power(int64_t& microwatts) const {
+    if (!ready_) return false;
+    microwatts = power_uw_;
+    return true;
+}
+
+bool EnergyMeter::average(int64_t& microwatts) const {
+    if (!ready_ || count_ == 0) return false;
+    const Point& oldest = window_[(head_ - count_ + 1 + kSlots) % kSlots];
+    int64_t dt_ns = last_ns_ - oldest.ns;
+    if (dt_ns <= 0) return false;
+    microwatts = static_cast<int64_t>(static_cast<double>(energy_uj_ - oldest.energy_uj) * 1e9 / dt_ns);
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+// CLOCK_MONOTONIC in nanoseconds.
+int64_t monotonic_ns();
+
+// Change of a monotonic kernel counter between two reads. Handles drivers
+// that expose 32-bit counters wrapping at 2^32; any other drop is treated as
+// a reset (interface re-created, stats cleared) and flagged via `reset`.
+uint64_t counter_delta(uint64_t prev, uint64_t cur, bool& reset);
+
+// Turns successive reads of a counter into an EWMA-smoothed per-second rate.
+class RateMeter {
+public:
+    RateMeter() = default;
+    explicit RateMeter(double tau_seconds) : tau_(tau_seconds) {}
+
+    // Returns true once a rate is available (i.e. from the second read on).
+    // A stale value (served from a cache, not re-read) is presumed unchanged:
+    // the rate decays toward zero, and the next fresh value is averaged over
+    // the whole time since the last fresh one.
+    bool update(uint64_t value, int64_t now_ns, bool fresh = true);
+
+    double rate() const { return rate_; }
+    uint64_t value() const { return value_; }
+    bool ready() const { return ready_; }
+
+private:
+    double tau_ = 2.0;
+    double rate_ = 0.0;
+    uint64_t value_ = 0;
+    int64_t stamp_ns_ = 0;  // last fresh value
+    int64_t decay_ns_ = 0;  // last update of rate_
+    bool primed_ = false;
+    bool ready_ = false;
+};
+
+// Energy over a session, from power readings or from a wrapping energy
+// counter, in a 64-bit fixed-point accumulator: whole microjoules plus the
+// exact remainder, so integrating thousands of short intervals loses nothing
+// to rounding. Also keeps the average power over the last kWindowNs.
+class EnergyMeter {
+public:
+    static constexpr int64_t kWindowNs = 10000000000;  // rolling average
+    static constexpr int64_t kMaxGapNs = 60000000000;  // longer gaps aren't integrated
+
+    // A power reading in µW, held until the next one (a left Riemann sum).
+    void add_power(int64_t microwatts, int64_t now_ns);
+    // An energy counter in µJ that wraps to 0 after `range` µJ (0: never).
+    void add_counter(uint64_t microjoules, uint64_t range, int64_t now_ns);
+
+    int64_t energy_uj() const { return energy_uj_; }
+    // Power over the latest interval; false until two readings.
+    bool power(int64_t& microwatts) const;
+    // Power over up to the last kWindowNs; false until two readings.
+    bool average(int64_t& microwatts) const;
+
+private:
+    static constexpr int kSlots = 10;  // a point a second over the window
+
+    void advance(int64_t added_uj, int64_t now_ns);
+
+    int64_t energy_uj_ = 0;
+    int64_t remainder_ = 0;  // µW·µs = pJ not yet a whole µJ
+    int64_t power_uw_ = 0;   // last reading, or the counter's last interval
+    uint64_t counter_ = 0;
+    int64_t stamp_ns_ = 0;   // time integrated up to
+    bool primed_ = false;
+    bool ready_ = false;
+
+    struct Point {
+        int64_t ns;
+        int64_t energy_uj;
+    };
+    Point window_[kSlots] = {};  // ring; the average runs from the oldest to now
+    int head_ = 0;               // newest point
+    int count_ = 0;
+    int64_t last_ns_ = 0;        // latest reading
+};
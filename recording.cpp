@@ -0,0 +1,283 @@
+#include "recording.hpp"
+
+#include "units.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rec {
+
+std::string read_string(const char* strings, uint64_t used, uint64_t offset) {
+    if (offset + 2 > used) return {};
+    uint16_t len;
+    std::memcpy(&len, strings + offset, sizeof(len));
+    if (offset + 2 + len > used) return {};
+    return std::string(strings + offset + 2, len);
+}
+
+// name, then one line per channel: key, label, unit, divisor, crit, has_crit
+// separated by tabs.
+std::string encode_info(const DeviceInfo& info) {
+    std::string out = info.name;
+    out.push_back('\n');
+    for (const auto& ch : info.channels) {
+        out.append(ch.key).push_back('\t');
+        out.append(ch.label).push_back('\t');
+        out.append(ch.unit ? ch.unit : "").push_back('\t');
+        out.append(std::to_string(ch.divisor)).push_back('\t');
+        out.append(std::to_string(ch.crit)).push_back('\t');
+        out.append(ch.has_crit ? "1" : "0").push_back('\n');
+    }
+    return out;
+}
+
+std::shared_ptr<const DeviceInfo> decode_info(const std::string& text) {
+    auto info = std::make_shared<DeviceInfo>();
+    size_t pos = text.find('\n');
+    info->name = text.substr(0, pos);
+    while (pos != std::string::npos && pos + 1 < text.size()) {
+        size_t end = text.find('\n', pos + 1);
+        std::string line = text.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+        pos = end;
+
+        std::string fields[6];
+        size_t start = 0;
+        for (int i = 0; i < 6; ++i) {
+            size_t tab = i < 5 ? line.find('\t', start) : std::string::npos;
+            fields[i] = line.substr(start, tab == std::string::npos ? std::string::npos : tab - start);
+            if (tab == std::string::npos) break;
+            start = tab + 1;
+        }
+        ChannelInfo ch;
+        ch.key = fields[0];
+        ch.label = fields[1];
+        ch.unit = intern_unit(fields[2]);
+        parse_i64(fields[3], ch.divisor);
+        parse_i64(fields[4], ch.crit);
+        ch.has_crit = fields[5] == "1";
+        if (ch.divisor <= 0) ch.divisor = 1;
+        info->channels.push_back(std::move(ch));
+    }
+    return info;
+}
+
+}  // namespace rec
+
+using namespace rec;
+
+static uint64_t align_page(uint64_t offset) {
+    return (offset + 4095) & ~uint64_t{4095};
+}
+
+Recorder::Recorder(const std::string& path, uint64_t size_bytes, int64_t interval_ns) {
+    uint64_t fixed = align_page(align_page(align_page(4096 + kMaxDevices * sizeof(RecDevice)) +
+                                           kMaxMetrics * sizeof(RecMetric)) + kStringBytes);
+    if (size_bytes < fixed + (1u << 20)) {
+        error_ = "recording size too small";
+        return;
+    }
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        error_ = path + ": " + std::strerror(errno);
+        return;
+    }
+    // Reserve the blocks up front so appends never hit ENOSPC as SIGBUS;
+    // filesystems without fallocate get a sparse file instead.
+    int rc = ::posix_fallocate(fd_, 0, static_cast<off_t>(size_bytes));
+    if (rc != 0 && (rc != EOPNOTSUPP || ::ftruncate(fd_, static_cast<off_t>(size_bytes)) != 0)) {
+        error_ = path + ": " + std::strerror(rc);
+        return;
+    }
+    void* map = ::mmap(nullptr, size_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        error_ = path + ": " + std::strerror(errno);
+        return;
+    }
+    base_ = static_cast<char*>(map);
+    size_ = size_bytes;
+
+    Header& h = header();
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(h.magic));
+    h.version = kVersion;
+    h.sample_size = sizeof(RecSample);
+    h.file_size = size_bytes;
+    h.interval_ns = interval_ns;
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    h.started_unix_ns = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+
+    h.devices_offset = 4096;
+    h.metrics_offset = align_page(h.devices_offset + kMaxDevices * sizeof(RecDevice));
+    h.strings_offset = align_page(h.metrics_offset + kMaxMetrics * sizeof(RecMetric));
+    h.ticks_offset = align_page(h.strings_offset + kStringBytes);
+    // A sixteenth of the rest for the tick index, which is plenty for the
+    // handful of samples a typical tick writes.
+    uint64_t rest = size_bytes - h.ticks_offset;
+    h.ticks_capacity = rest / 16 / sizeof(RecTick);
+    h.records_offset = align_page(h.ticks_offset + h.ticks_capacity * sizeof(RecTick));
+    h.records_capacity = (size_bytes - h.records_offset) / sizeof(RecSample);
+}
+
+Recorder::~Recorder() {
+    if (base_) {
+        ::msync(base_, size_, MS_SYNC);
+        ::munmap(base_, size_);
+    }
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool Recorder::intern(const std::string& s, uint32_t& offset) {
+    auto it = strings_.find(s);
+    if (it != strings_.end()) {
+        offset = it->second;
+        return true;
+    }
+    if (s.size() > UINT16_MAX || strings_used_ + 2 + s.size() > kStringBytes) return false;
+
+    char* at = base_ + header().strings_offset + strings_used_;
+    uint16_t len = static_cast<uint16_t>(s.size());
+    std::memcpy(at, &len, sizeof(len));
+    std::memcpy(at + 2, s.data(), s.size());
+    offset = static_cast<uint32_t>(strings_used_);
+    strings_used_ += 2 + s.size();
+    strings_.emplace(s, offset);
+    return true;
+}
+
+bool Recorder::add_device(const Snapshot& snap, Device& dev) {
+    const char* driver = snap.driver ? snap.driver->name() : "";
+    if (devices_used_ == kMaxDevices || snap.path.size() >= sizeof(RecDevice::path) ||
+        std::strlen(driver) >= sizeof(RecDevice::driver)) {
+        return false;
+    }
+
+    dev.id = static_cast<uint32_t>(devices_used_);
+    RecDevice& out = reinterpret_cast<RecDevice*>(base_ + header().devices_offset)[dev.id];
+    std::memset(&out, 0, sizeof(out));
+    std::memcpy(out.path, snap.path.c_str(), snap.path.size());
+    std::memcpy(out.driver, driver, std::strlen(driver));
+    out.info_offset = kNone;
+    ++devices_used_;
+    return metric(dev, "", kPresence, 0, dev.presence);
+}
+
+bool Recorder::metric(Device& dev, std::string_view key, uint16_t kind, uint16_t flags, uint32_t& id) {
+    auto it = dev.metrics.find(key);
+    if (it != dev.metrics.end()) {
+        id = it->second;
+        return true;
+    }
+    if (metrics_used_ == kMaxMetrics || key.size() >= sizeof(RecMetric::key)) return false;
+
+    id = static_cast<uint32_t>(metrics_used_);
+    RecMetric& out = reinterpret_cast<RecMetric*>(base_ + header().metrics_offset)[id];
+    std::memset(&out, 0, sizeof(out));
+    out.device = dev.id;
+    out.kind = kind;
+    out.flags = flags;
+    std::memcpy(out.key, key.data(), key.size());
+    out.last = kNone;
+    ++metrics_used_;
+
+    dev.metrics.emplace(std::string(key), id);
+    last_value_.push_back(0);
+    last_sample_.push_back(kNone);
+    return true;
+}
+
+bool Recorder::sample(uint32_t metric, uint32_t tick, int64_t value, bool keyframe) {
+    if (!keyframe && last_sample_[metric] != kNone && last_value_[metric] == value) return true;
+    if (records_ == header().records_capacity) return false;
+
+    RecSample& out = reinterpret_cast<RecSample*>(base_ + header().records_offset)[records_];
+    out.metric = metric;
+    out.tick = tick;
+    out.value = value;
+    out.prev = last_sample_[metric];
+    out.reserved = 0;
+    last_sample_[metric] = static_cast<uint32_t>(records_++);
+    last_value_[metric] = value;
+    touched_.push_back(metric);
+    return true;
+}
+
+bool Recorder::append(const std::vector<Snapshot>& devices, int64_t now_ns) {
+    if (!base_ || full_) return false;
+    Header& h = header();
+    if (h.ticks == h.ticks_capacity) {
+        full_ = true;
+        return false;
+    }
+    if (first_ns_ < 0) first_ns_ = now_ns;
+
+    uint32_t tick = static_cast<uint32_t>(h.ticks);
+    bool keyframe = tick % kKeyframeTicks == 0;
+    records_ = h.records;
+    touched_.clear();
+    bool ok = true;
+
+    for (auto& entry : devices_) entry.second.seen = false;
+    for (const auto& snap : devices) {
+        auto it = devices_.find(snap.path);
+        if (it == devices_.end()) {
+            Device dev;
+            if (!add_device(snap, dev)) continue;  // table full or path too long: skip it
+            it = devices_.emplace(snap.path, std::move(dev)).first;
+        }
+        Device& dev = it->second;
+        dev.seen = true;
+
+        if (snap.info && snap.info.get() != dev.info) {
+            uint32_t offset;
+            if (intern(encode_info(*snap.info), offset)) {
+                reinterpret_cast<RecDevice*>(base_ + h.devices_offset)[dev.id].info_offset = offset;
+                dev.info = snap.info.get();
+            }
+        }
+
+        ok = ok && sample(dev.presence, tick, 1, keyframe);
+        for (const auto& kv : snap.values) {
+            uint32_t id, offset;
+            if (!metric(dev, kv.first, kString, 0, id) || !intern(kv.second, offset)) continue;
+            ok = ok && sample(id, tick, offset, keyframe);
+        }
+        for (const auto& kv : snap.numbers) {
+            uint32_t id;
+            uint16_t flags = snap.series(kv.first) ? kTracked : 0;
+            if (!metric(dev, kv.first, kNumber, flags, id)) continue;
+            ok = ok && sample(id, tick, kv.second, keyframe);
+        }
+    }
+    for (auto& entry : devices_) {
+        Device& dev = entry.second;
+        if (!dev.seen && last_value_[dev.presence] == 1) ok = ok && sample(dev.presence, tick, 0, false);
+    }
+
+    if (!ok) {
+        // Out of sample space: this tick is dropped and the file ends at
+        // the previous one.
+        full_ = true;
+        return false;
+    }
+
+    RecTick& out = reinterpret_cast<RecTick*>(base_ + h.ticks_offset)[tick];
+    out.t_ns = now_ns - first_ns_;
+    out.first_sample = static_cast<uint32_t>(h.records);
+    out.flags = keyframe ? static_cast<uint32_t>(kKeyframe) : 0;
+
+    RecMetric* metrics = reinterpret_cast<RecMetric*>(base_ + h.metrics_offset);
+    for (uint32_t m : touched_) metrics[m].last = last_sample_[m];
+
+    // A reader that sees the new tick count sees everything it covers.
+    __atomic_store_n(&h.devices, devices_used_, __ATOMIC_RELEASE);
+    __atomic_store_n(&h.metrics, metrics_used_, __ATOMIC_RELEASE);
+    __atomic_store_n(&h.strings_used, strings_used_, __ATOMIC_RELEASE);
+    __atomic_store_n(&h.records, records_, __ATOMIC_RELEASE);
+    __atomic_store_n(&h.ticks, tick + 1, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "sensors.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// On-disk recording (--record), in host byte order like encode_binary. The
+// file is preallocated at its full size and mapped; everything is appended
+// in place and the header counts are published with release stores once a
+// tick's entries are written (ticks last), so a crash or a concurrent reader
+// only ever sees complete entries. Regions, at the offsets given in the header:
+//   devices  RecDevice per device
+//   metrics  RecMetric per (device, key): the per-metric index, including
+//            the newest record of each metric
+//   strings  string values and serialized DeviceInfo, u16 length + bytes,
+//            each distinct string stored once
+//   ticks    RecTick per sampling tick, sorted by time, for binary search
+//   records  RecSample per changed value; each links to the previous
+//            sample of its metric
+// A tick only holds the values that changed, except every kKeyframeTicks
+// ticks, which hold every value so a seek never replays more than that.
+namespace rec {
+
+constexpr char kMagic[] = "KMAPREC1";
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kKeyframeTicks = 120;
+constexpr uint32_t kNone = UINT32_MAX;
+
+constexpr size_t kMaxDevices = 1024;
+constexpr size_t kMaxMetrics = 16384;
+constexpr size_t kStringBytes = 4u << 20;
+
+enum MetricKind : uint16_t {
+    kPresence = 0,  // 1 while the device exists, 0 once it's gone
+    kNumber = 1,
+    kString = 2,    // value is an offset into the string region
+};
+enum MetricFlags : uint16_t {
+    kTracked = 1,   // the driver keeps history for it
+};
+enum TickFlags : uint32_t {
+    kKeyframe = 1,
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_size;
+    uint64_t file_size;
+    int64_t interval_ns;
+    int64_t started_unix_ns;
+
+    uint64_t devices_offset, metrics_offset, strings_offset, ticks_offset, records_offset;
+    uint64_t ticks_capacity, records_capacity;
+
+    // Published counts; everything below them is complete. Stored with
+    // release semantics, ticks last: load ticks with acquire first.
+    uint64_t devices, metrics, strings_used, ticks, records;
+};
+
+struct RecDevice {
+    char path[120];
+    char driver[16];
+    uint32_t info_offset;  // serialized DeviceInfo in strings, kNone if none
+    uint32_t reserved;
+};
+
+struct RecMetric {
+    uint32_t device;
+    uint16_t kind;
+    uint16_t flags;
+    char key[24];
+    uint32_t last;  // newest RecSample of this metric, kNone before the first
+    uint32_t reserved;
+};
+
+struct RecTick {
+    int64_t t_ns;           // monotonic, relative to the first tick
+    uint32_t first_sample;  // samples [first_sample, next tick's first_sample)
+    uint32_t flags;
+};
+
+struct RecSample {
+    uint32_t metric;
+    uint32_t tick;
+    int64_t value;
+    uint32_t prev;  // previous sample of the same metric, kNone if first
+    uint32_t reserved;
+};
+
+// Reads the u16-prefixed string at `offset`; empty if out of range.
+std::string read_string(const char* strings, uint64_t used, uint64_t offset);
+
+std::string encode_info(const DeviceInfo& info);
+std::shared_ptr<const DeviceInfo> decode_info(const std::string& text);
+
+}  // namespace rec
+
+// Appends ticks to a new recording. Fails (ok() false) when the file can't
+// be created; once a region fills up, append() returns false and the file
+// stays valid up to the last complete tick.
+class Recorder {
+public:
+    Recorder(const std::string& path, uint64_t size_bytes, int64_t interval_ns);
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    bool ok() const { return base_ != nullptr; }
+    const std::string& error() const { return error_; }
+
+    bool append(const std::vector<Snapshot>& devices, int64_t now_ns);
+
+private:
+    struct Device {
+        uint32_t id;
+        uint32_t presence;
+        const DeviceInfo* info = nullptr;
+        std::map<std::string, uint32_t, std::less<>> metrics;
+        bool seen = false;
+    };
+
+    rec::Header& header() { return *reinterpret_cast<rec::Header*>(base_); }
+    bool add_device(const Snapshot& snap, Device& dev);
+    bool metric(Device& dev, std::string_view key, uint16_t kind, uint16_t flags, uint32_t& id);
+    bool intern(const std::string& s, uint32_t& offset);
+    bool sample(uint32_t metric, uint32_t tick, int64_t value, bool keyframe);
+
+    std::string error_;
+    int fd_ = -1;
+    char* base_ = nullptr;
+    uint64_t size_ = 0;
+    int64_t first_ns_ = -1;
+    bool full_ = false;
+
+    std::map<std::string, Device, std::less<>> devices_;
+    std::map<std::string, uint32_t, std::less<>> strings_;
+    std::vector<int64_t> last_value_;   // per metric, what the newest sample holds
+    std::vector<uint32_t> last_sample_;  // per metric, newest sample index
+    std::vector<uint32_t> touched_;      // metrics sampled in the current tick
+    // Entries written, published to the header per tick.
+    uint64_t devices_used_ = 0;
+    uint64_t metrics_used_ = 0;
+    uint64_t strings_used_ = 0;
+    uint64_t records_ = 0;
+};
@@ -0,0 +1,40 @@
+#include "redraw.hpp"
+
+RedrawLimiter::RedrawLimiter(int max_fps, std::function<void()> post)
+    : frame_(1000000 / (max_fps > 0 ? max_fps : 1)), post_(std::move(post)) {
+    thread_ = std::thread(&RedrawLimiter::run, this);
+}
+
+RedrawLimiter::~RedrawLimiter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void RedrawLimiter::request() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_) return;
+        pending_ = true;
+    }
+    wake_.notify_all();
+}
+
+void RedrawLimiter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stop_ || pending_; });
+        if (stop_) return;
+        pending_ = false;
+
+        lock.unlock();
+        post_();
+        lock.lock();
+
+        // Hold off for the rest of the frame; stop still interrupts.
+        if (wake_.wait_for(lock, frame_, [this] { return stop_; })) return;
+    }
+}
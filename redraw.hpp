@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Coalesces redraw requests from background threads (sampler, hotplug) into
+// at most one post per frame budget, so a fast sampler can't flood the
+// terminal. Requests arriving inside the budget are merged into one post at
+// the end of it; none are dropped.
+class RedrawLimiter {
+public:
+    RedrawLimiter(int max_fps, std::function<void()> post);
+    ~RedrawLimiter();
+
+    RedrawLimiter(const RedrawLimiter&) = delete;
+    RedrawLimiter& operator=(const RedrawLimiter&) = delete;
+
+    // Thread-safe and never blocks on the UI.
+    void request();
+
+private:
+    void run();
+
+    std::chrono::microseconds frame_;
+    std::function<void()> post_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool pending_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,261 @@
+#include "remote.hpp"
+
+#include "rates.hpp"
+#include "sockets.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <iterator>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static constexpr uint64_t kWakeId = ~0ull;
+static constexpr int kMaxEvents = 64;
+
+static std::vector<std::string> labels(const std::vector<std::string>& addresses) {
+    std::vector<std::string> out;
+    for (const auto& address : addresses) out.push_back(RemoteClient::host_label(address));
+    return out;
+}
+
+RemoteClient::RemoteClient(std::vector<std::string> addresses, const std::vector<std::unique_ptr<Sensor>>& drivers,
+                           std::function<void()> on_update)
+    : hosts_(addresses.size()),
+      on_update_(std::move(on_update)),
+      history_(std::max<size_t>(1024, kSeriesPerHost * addresses.size())),
+      rack_(labels(addresses)) {
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        hosts_[i].label = host_label(addresses[i]);
+        hosts_[i].address = std::move(addresses[i]);
+    }
+    for (const auto& driver : drivers) drivers_.emplace_back(driver->name(), driver.get());
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kWakeId;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    thread_ = std::thread(&RemoteClient::run, this);
+}
+
+RemoteClient::~RemoteClient() {
+    stop_.store(true);
+    uint64_t one = 1;
+    if (wake_fd_ >= 0) (void)!::write(wake_fd_, &one, sizeof(one));
+    if (thread_.joinable()) thread_.join();
+    for (auto& host : hosts_) {
+        if (host.fd >= 0) ::close(host.fd);
+    }
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+}
+
+std::string RemoteClient::host_label(const std::string& address) {
+    if (address.find('/') != std::string::npos) return address.substr(address.rfind('/') + 1);
+    size_t colon = address.rfind(':');
+    std::string host = colon == std::string::npos ? address : address.substr(0, colon);
+    return host.empty() ? "localhost" : host;
+}
+
+std::shared_ptr<const SnapshotSet> RemoteClient::latest() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void RemoteClient::connect(size_t index, int64_t now_ns) {
+    Host& host = hosts_[index];
+    std::string error;
+    host.fd = start_connect(host.address, error);
+    if (host.fd < 0) {
+        host.retry_ns = now_ns + kRetryNs;
+        return;
+    }
+    // Writable once connected; readable from then on.
+    host.connecting = true;
+    epoll_event ev{};
+    ev.events = EPOLLOUT;
+    ev.data.u64 = index;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, host.fd, &ev) < 0) disconnect(index);
+}
+
+void RemoteClient::disconnect(size_t index) {
+    Host& host = hosts_[index];
+    ::close(host.fd);  // also takes it off the epoll set
+    host.fd = -1;
+    host.connecting = false;
+    host.retry_ns = monotonic_ns() + kRetryNs;
+    host.decoder.reset();
+    // The next connection starts a new stream, with devices numbered afresh.
+    for (const auto& entry : host.devices) history_.release(entry.second.path);
+    host.devices.clear();
+    host.synced_layout = ~0ull;
+    rack_.disconnect(index);
+    retry_due_ns_ = std::min(retry_due_ns_, host.retry_ns);
+}
+
+void RemoteClient::sync(Host& host) {
+    auto it = host.devices.begin();
+    auto drop = [&] {
+        history_.release(it->second.path);
+        it = host.devices.erase(it);
+    };
+    for (const auto& entry : host.decoder.devices()) {
+        while (it != host.devices.end() && it->first < entry.first) drop();
+        if (it != host.devices.end() && it->first == entry.first) {
+            if (it->second.wire_path == entry.second.path) {
+                ++it;
+                continue;
+            }
+            drop();  // the id was reused for another device
+        }
+        DeviceHistory fresh;
+        fresh.wire_path = entry.second.path;
+        fresh.path = host.label + ":" + entry.second.path;
+        it = std::next(host.devices.emplace_hint(it, entry.first, std::move(fresh)));
+    }
+    while (it != host.devices.end()) drop();
+    host.synced_layout = host.decoder.layout();
+}
+
+RemoteClient::DeviceHistory& RemoteClient::history(Host& host, std::map<uint32_t, DeviceHistory>::iterator it,
+                                                   const WireDevice& dev) {
+    DeviceHistory& h = it->second;
+    if (h.tracked != dev.tracked) {
+        const auto& keys = host.decoder.keys();
+        h.tracked = dev.tracked;
+        h.series.clear();
+        for (uint32_t key : h.tracked) h.series.push_back(history_.series(h.path, keys[key]));
+    }
+    return h;
+}
+
+bool RemoteClient::receive(size_t index, bool& updated, bool& relayout) {
+    char* buf = buffer_.data();
+    Host& host = hosts_[index];
+
+    for (int reads = 0; reads < kMaxReads; ++reads) {
+        ssize_t n = ::recv(host.fd, buf, buffer_.size(), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+
+        uint64_t layout = host.decoder.layout();
+        // Each frame is one remote tick: history advances once per frame.
+        bool ok = host.decoder.feed(buf, static_cast<size_t>(n), [&](int64_t) {
+            if (host.decoder.layout() != host.synced_layout) sync(host);
+            auto cached = host.devices.begin();
+            for (const auto& entry : host.decoder.devices()) {
+                const WireDevice& dev = entry.second;
+                const DeviceHistory& h = history(host, cached++, dev);
+                for (size_t i = 0; i < h.tracked.size(); ++i) {
+                    if (!h.series[i]) continue;
+                    auto value = dev.numbers.find(h.tracked[i]);
+                    if (value != dev.numbers.end()) h.series[i]->push(value->second);
+                }
+            }
+            rack_.update(index, host.decoder);
+            updated = true;
+        });
+        if (!ok) return false;
+        relayout |= host.decoder.layout() != layout;
+        // A short read means the socket is drained for now.
+        if (static_cast<size_t>(n) < buffer_.size()) return true;
+    }
+    return true;  // more pending; level-triggered, so picked up next round
+}
+
+// Rebuilds the published set from every host's decoded state.
+void RemoteClient::publish() {
+    auto set = std::make_shared<SnapshotSet>();
+    uint64_t version = 14695981039346656037ull;
+    int64_t now = monotonic_ns();
+
+    for (auto& host : hosts_) {
+        const auto& keys = host.decoder.keys();
+        if (host.decoder.layout() != host.synced_layout) sync(host);
+        auto cached = host.devices.begin();
+        for (const auto& entry : host.decoder.devices()) {
+            const WireDevice& dev = entry.second;
+            const DeviceHistory& h = history(host, cached++, dev);
+            Snapshot& snap = set->devices.emplace_back();
+            snap.path = h.path;
+            for (const auto& d : drivers_) {
+                if (d.first == dev.driver) snap.driver = d.second;
+            }
+            snap.info = dev.info;
+            snap.timestamp_ns = now;
+            for (const auto& kv : dev.values) snap.set(keys[kv.first], kv.second);
+            for (const auto& kv : dev.numbers) snap.set_number(keys[kv.first], kv.second);
+            for (size_t i = 0; i < h.tracked.size(); ++i) snap.track(keys[h.tracked[i]], h.series[i]);
+            snap.version = snap.digest();
+            version = (version ^ snap.version) * 1099511628211ull;
+        }
+    }
+    set->version = version;
+    std::atomic_store(&snapshot_, std::shared_ptr<const SnapshotSet>(std::move(set)));
+    rack_.publish();
+    if (on_update_) on_update_();
+}
+
+void RemoteClient::run() {
+    epoll_event events[kMaxEvents];
+    bool pending = false;  // frames decoded since the last publish
+    int64_t published_ns = 0;
+
+    while (!stop_.load()) {
+        int64_t now = monotonic_ns();
+        // Only walk the hosts when one of them is due a retry.
+        if (now >= retry_due_ns_) {
+            retry_due_ns_ = INT64_MAX;
+            for (size_t i = 0; i < hosts_.size(); ++i) {
+                Host& host = hosts_[i];
+                if (host.fd < 0 && now >= host.retry_ns) connect(i, now);
+                if (host.fd < 0) retry_due_ns_ = std::min(retry_due_ns_, host.retry_ns);
+            }
+        }
+
+        int64_t deadline = std::min(retry_due_ns_, pending ? published_ns + kPublishNs : now + 1000000000);
+        int timeout = static_cast<int>(std::clamp<int64_t>((deadline - now + 999999) / 1000000, 0, 1000));
+        int ready = ::epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+        if (ready < 0 && errno != EINTR) break;
+
+        bool relayout = false;
+        for (int e = 0; e < ready; ++e) {
+            if (events[e].data.u64 == kWakeId) return;
+            size_t index = static_cast<size_t>(events[e].data.u64);
+            Host& host = hosts_[index];
+            if (host.fd < 0) continue;  // dropped earlier in this batch
+
+            if (host.connecting) {
+                std::string error;
+                if (!finish_connect(host.fd, error)) {
+                    disconnect(index);
+                    continue;
+                }
+                host.connecting = false;
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.u64 = index;
+                ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, host.fd, &ev);
+                continue;
+            }
+            if (!receive(index, pending, relayout)) {
+                disconnect(index);
+                pending = relayout = true;
+            }
+        }
+
+        // Devices coming or going are shown right away; value changes from
+        // any number of hosts share one publish per kPublishNs.
+        now = monotonic_ns();
+        if (pending && (relayout || now - published_ns >= kPublishNs)) {
+            publish();
+            pending = false;
+            published_ns = now;
+        }
+        // After publishing, so a UI that sees the bump also sees the devices.
+        if (relayout) layout_.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "history.hpp"
+#include "rack.hpp"
+#include "sampler.hpp"
+#include "sensors.hpp"
+#include "wire.hpp"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// TUI side of remote mode: keeps a connection to each kmapd address on a
+// background thread, rebuilds their state from the delta stream, and
+// publishes it as a SnapshotSet just like Sampler does. Device paths are
+// prefixed with the host, e.g. "node1:/sys/class/net/eth0", and snapshots
+// are bound to the local driver of the same name so rendering is
+// unchanged. Dropped connections are retried every couple of seconds.
+//
+// Every host is a non-blocking socket on one epoll loop, so a slow or dead
+// agent never holds up the others, and frames from many hosts are coalesced
+// into at most one published set per kPublishNs. Along with the set, each
+// host's headline numbers go to a RackStore for the rack view.
+//
+// History slots are resolved once per device and tracked-key list and
+// pushed through cached pointers, so a steady frame neither builds paths
+// nor looks them up. A device's slots go back to the store when its host
+// removes it or the connection drops; the store has room for kSeriesPerHost
+// per host.
+class RemoteClient : public SnapshotSource {
+public:
+    RemoteClient(std::vector<std::string> addresses, const std::vector<std::unique_ptr<Sensor>>& drivers,
+                 std::function<void()> on_update);
+    ~RemoteClient() override;
+
+    RemoteClient(const RemoteClient&) = delete;
+    RemoteClient& operator=(const RemoteClient&) = delete;
+
+    std::shared_ptr<const SnapshotSet> latest() const override;
+    uint64_t layout() const override { return layout_.load(std::memory_order_acquire); }
+
+    // Per-host rollups, published along with latest(); nullptr until the
+    // first frame.
+    std::shared_ptr<const RackColumns> rack() const { return rack_.latest(); }
+    size_t hosts() const { return hosts_.size(); }
+
+    // "node1" for "node1:9476", the socket file name for a Unix path.
+    static std::string host_label(const std::string& address);
+
+private:
+    static constexpr int64_t kRetryNs = 2000000000;
+    static constexpr int64_t kPublishNs = 100000000;
+    // recv() calls per host per wakeup, so one busy stream can't starve the rest.
+    static constexpr int kMaxReads = 4;
+    static constexpr size_t kSeriesPerHost = 512;
+
+    // A decoded device's prefixed path and history slots.
+    struct DeviceHistory {
+        std::string wire_path;          // as the host sent it
+        std::string path;               // "node1:" + wire_path
+        std::vector<uint32_t> tracked;  // keys `series` was resolved for
+        std::vector<Series*> series;    // parallel to tracked; nullptr once the store is full
+    };
+
+    struct Host {
+        std::string address;
+        std::string label;
+        int fd = -1;
+        bool connecting = false;  // waiting for the socket to become writable
+        int64_t retry_ns = 0;
+        DeltaDecoder decoder;
+        std::map<uint32_t, DeviceHistory> devices;  // same ids as decoder.devices() once synced
+        uint64_t synced_layout = ~0ull;
+    };
+
+    void run();
+    void connect(size_t index, int64_t now_ns);
+    // Reads what the host has sent; false once the connection is gone.
+    bool receive(size_t index, bool& updated, bool& relayout);
+    void disconnect(size_t index);
+    // Brings host.devices in line with the decoder's devices, releasing
+    // the history of those that went away.
+    void sync(Host& host);
+    // The device's history slots, re-resolved if its tracked keys changed.
+    DeviceHistory& history(Host& host, std::map<uint32_t, DeviceHistory>::iterator it, const WireDevice& dev);
+    void publish();
+
+    std::vector<Host> hosts_;
+    std::vector<std::pair<std::string, Sensor*>> drivers_;
+    std::function<void()> on_update_;
+
+    // Client thread only.
+    HistoryStore history_;
+    RackStore rack_;
+    std::vector<char> buffer_ = std::vector<char>(64 * 1024);  // shared: hosts are read one at a time
+    int64_t retry_due_ns_ = 0;  // earliest retry_ns of a disconnected host
+
+    std::atomic<uint64_t> layout_{0};
+    std::shared_ptr<const SnapshotSet> snapshot_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
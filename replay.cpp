@@ -0,0 +1,303 @@
+#include "replay.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace rec;
+
+Replayer::Replayer(const std::string& path, const std::vector<std::unique_ptr<Sensor>>& drivers,
+                   std::function<void()> on_update)
+    : on_update_(std::move(on_update)) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd_ < 0 || ::fstat(fd_, &st) < 0) {
+        error_ = path + ": " + std::strerror(errno);
+        return;
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    if (size_ < sizeof(Header)) {
+        error_ = path + ": not a kmap recording";
+        return;
+    }
+    void* map = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        error_ = path + ": " + std::strerror(errno);
+        return;
+    }
+    base_ = static_cast<const char*>(map);
+
+    const Header& h = header();
+    // The recorder stores ticks last, so everything these counts cover is
+    // complete even if it is still writing.
+    ticks_ = __atomic_load_n(&h.ticks, __ATOMIC_ACQUIRE);
+    records_ = __atomic_load_n(&h.records, __ATOMIC_ACQUIRE);
+    strings_used_ = __atomic_load_n(&h.strings_used, __ATOMIC_ACQUIRE);
+    uint64_t device_count = __atomic_load_n(&h.devices, __ATOMIC_ACQUIRE);
+    uint64_t metric_count = __atomic_load_n(&h.metrics, __ATOMIC_ACQUIRE);
+    auto fits = [&](uint64_t offset, uint64_t count, size_t elem) {
+        return offset <= size_ && count <= (size_ - offset) / elem;
+    };
+    if (std::memcmp(h.magic, kMagic, sizeof(h.magic)) != 0 || h.version != kVersion ||
+        h.sample_size != sizeof(RecSample) || !fits(h.devices_offset, device_count, sizeof(RecDevice)) ||
+        !fits(h.metrics_offset, metric_count, sizeof(RecMetric)) || !fits(h.strings_offset, strings_used_, 1) ||
+        !fits(h.ticks_offset, ticks_, sizeof(RecTick)) || !fits(h.records_offset, records_, sizeof(RecSample))) {
+        error_ = path + ": not a kmap recording (or from another version)";
+        ::munmap(map, size_);
+        base_ = nullptr;
+        return;
+    }
+    if (ticks_ == 0) {
+        error_ = path + ": recording is empty";
+        ::munmap(map, size_);
+        base_ = nullptr;
+        return;
+    }
+    // Samples of a tick committed after ticks_ was loaded.
+    while (records_ > 0 && sample_at(static_cast<uint32_t>(records_ - 1)).tick >= ticks_) --records_;
+    metrics_ = reinterpret_cast<const RecMetric*>(base_ + h.metrics_offset);
+    strings_ = base_ + h.strings_offset;
+
+    // The catalog is small; index it up front.
+    const RecDevice* devices = reinterpret_cast<const RecDevice*>(base_ + h.devices_offset);
+    devices_.resize(device_count);
+    for (size_t i = 0; i < device_count; ++i) {
+        Device& dev = devices_[i];
+        dev.path.assign(devices[i].path, strnlen(devices[i].path, sizeof(devices[i].path)));
+        std::string driver(devices[i].driver, strnlen(devices[i].driver, sizeof(devices[i].driver)));
+        for (const auto& d : drivers) {
+            if (driver == d->name()) dev.driver = d.get();
+        }
+        if (devices[i].info_offset != kNone) {
+            dev.info = decode_info(read_string(strings_, strings_used_, devices[i].info_offset));
+        }
+    }
+    values_.assign(metric_count, 0);
+    latest_.assign(metric_count, kNone);
+    series_.assign(metric_count, nullptr);
+    keys_.assign(metric_count, std::string_view());
+    for (uint32_t m = 0; m < metric_count; ++m) {
+        const RecMetric& metric = metrics_[m];
+        keys_[m] = paths().key(std::string_view(metric.key, strnlen(metric.key, sizeof(metric.key))));
+        if (metric.device >= devices_.size()) continue;
+        Device& dev = devices_[metric.device];
+        if (metric.kind == kPresence) {
+            dev.presence = m;
+            continue;
+        }
+        dev.metrics.push_back(m);
+        if (metric.flags & kTracked) {
+            series_[m] = history_.series(dev.path, keys_[m]);
+        }
+    }
+    present_.assign(devices_.size(), false);
+
+    status_.length_ns = tick_at(static_cast<uint32_t>(ticks_ - 1)).t_ns;
+    thread_ = std::thread(&Replayer::run, this);
+}
+
+Replayer::~Replayer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    if (base_) ::munmap(const_cast<char*>(base_), size_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+const RecTick& Replayer::tick_at(uint32_t i) const {
+    return reinterpret_cast<const RecTick*>(base_ + header().ticks_offset)[i];
+}
+
+const RecSample& Replayer::sample_at(uint32_t i) const {
+    return reinterpret_cast<const RecSample*>(base_ + header().records_offset)[i];
+}
+
+uint32_t Replayer::tick_end(uint32_t tick) const {
+    return tick + 1 < ticks_ ? tick_at(tick + 1).first_sample : static_cast<uint32_t>(records_);
+}
+
+std::shared_ptr<const SnapshotSet> Replayer::latest() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void Replayer::toggle_pause() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.paused = !status_.paused;
+        // Resuming at the end starts over.
+        if (!status_.paused && status_.position_ns >= status_.length_ns) {
+            seek_ns_ = -status_.length_ns;
+            seek_pending_ = true;
+        }
+    }
+    wake_.notify_all();
+}
+
+void Replayer::toggle_speed() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.speed = status_.speed == 1 ? 10 : 1;
+    }
+    wake_.notify_all();
+}
+
+void Replayer::seek(int64_t delta_ns) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        seek_ns_ += delta_ns;
+        seek_pending_ = true;
+    }
+    wake_.notify_all();
+}
+
+Replayer::Status Replayer::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+// Last tick at or before t_ns.
+uint32_t Replayer::find_tick(int64_t t_ns) const {
+    uint32_t lo = 0, hi = static_cast<uint32_t>(ticks_);
+    while (hi - lo > 1) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (tick_at(mid).t_ns <= t_ns) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void Replayer::apply(uint32_t tick) {
+    if (tick_at(tick).flags & kKeyframe) std::fill(latest_.begin(), latest_.end(), kNone);
+    uint32_t end = tick_end(tick);
+    for (uint32_t i = tick_at(tick).first_sample; i < end; ++i) {
+        const RecSample& s = sample_at(i);
+        if (s.metric >= values_.size()) continue;
+        values_[s.metric] = s.value;
+        latest_[s.metric] = i;
+    }
+    tick_ = tick;
+}
+
+void Replayer::push_history() {
+    for (size_t m = 0; m < series_.size(); ++m) {
+        if (series_[m] && latest_[m] != kNone) series_[m]->push(values_[m]);
+    }
+}
+
+void Replayer::rebuild(uint32_t target) {
+    uint32_t key = target;
+    while (key > 0 && !(tick_at(key).flags & kKeyframe)) --key;
+    std::fill(latest_.begin(), latest_.end(), kNone);
+    for (uint32_t t = key; t <= target; ++t) apply(t);
+
+    // Refill graphs with the values each tick had, from the sample chains.
+    uint32_t first = target >= Series::kCapacity ? target - Series::kCapacity + 1 : 0;
+    std::vector<std::pair<uint32_t, int64_t>> chain;
+    for (size_t m = 0; m < series_.size(); ++m) {
+        if (!series_[m] || latest_[m] == kNone) continue;
+        chain.clear();
+        for (uint32_t i = latest_[m]; i != kNone && i < records_;) {
+            const RecSample& s = sample_at(i);
+            chain.push_back({s.tick, s.value});
+            if (s.tick <= first) break;
+            i = s.prev;
+        }
+        // chain is newest first; emit oldest first, one value per tick.
+        size_t next = chain.size();
+        for (uint32_t t = first; t <= target; ++t) {
+            while (next > 1 && chain[next - 2].first <= t) --next;
+            if (next == 0 || chain[next - 1].first > t) continue;
+            series_[m]->push(chain[next - 1].second);
+        }
+    }
+}
+
+void Replayer::publish() {
+    auto set = std::make_shared<SnapshotSet>();
+    uint64_t version = 14695981039346656037ull;
+    bool relayout = false;
+
+    for (size_t d = 0; d < devices_.size(); ++d) {
+        const Device& dev = devices_[d];
+        bool present = dev.presence != kNone && latest_[dev.presence] != kNone && values_[dev.presence] == 1;
+        relayout |= present != present_[d];
+        present_[d] = present;
+        if (!present) continue;
+
+        Snapshot& snap = set->devices.emplace_back();
+        snap.path = dev.path;
+        snap.driver = dev.driver;
+        snap.info = dev.info;
+        snap.timestamp_ns = tick_at(tick_).t_ns;
+        for (uint32_t m : dev.metrics) {
+            if (latest_[m] == kNone) continue;
+            std::string_view key = keys_[m];
+            if (metrics_[m].kind == kString) {
+                snap.set(key, read_string(strings_, strings_used_, static_cast<uint64_t>(values_[m])));
+            } else {
+                snap.set_number(key, values_[m]);
+            }
+            if (series_[m]) snap.track(key, series_[m]);
+        }
+        snap.version = snap.digest();
+        version = (version ^ snap.version) * 1099511628211ull;
+    }
+    set->version = version;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_.position_ns = tick_at(tick_).t_ns;
+    }
+    std::atomic_store(&snapshot_, std::shared_ptr<const SnapshotSet>(std::move(set)));
+    if (relayout) layout_.fetch_add(1, std::memory_order_release);
+    if (on_update_) on_update_();
+}
+
+void Replayer::run() {
+    rebuild(0);
+    publish();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (seek_pending_) {
+            int64_t target = tick_at(tick_).t_ns + seek_ns_;
+            seek_ns_ = 0;
+            seek_pending_ = false;
+            lock.unlock();
+            rebuild(find_tick(std::max<int64_t>(target, 0)));
+            publish();
+            lock.lock();
+            continue;
+        }
+        if (tick_ + 1 >= ticks_) status_.paused = true;
+        if (status_.paused) {
+            wake_.wait(lock, [this] { return stop_ || seek_pending_ || !status_.paused; });
+            continue;
+        }
+
+        // Wait out the recorded gap to the next tick, scaled by the speed;
+        // any control change restarts the wait.
+        Status before = status_;
+        int64_t gap = (tick_at(tick_ + 1).t_ns - tick_at(tick_).t_ns) / status_.speed;
+        bool interrupted = wake_.wait_for(lock, std::chrono::nanoseconds(gap), [&] {
+            return stop_ || seek_pending_ || status_.paused != before.paused || status_.speed != before.speed;
+        });
+        if (interrupted) continue;
+
+        lock.unlock();
+        apply(tick_ + 1);
+        push_history();
+        publish();
+        lock.lock();
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "history.hpp"
+#include "recording.hpp"
+#include "sampler.hpp"
+#include "sensors.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays a --record file back into the UI as a SnapshotSource. The file is
+// mapped read-only and only the pages a position needs are touched: a seek
+// binary-searches the tick index, replays from the keyframe before the
+// target, and walks each graphed metric's sample chain back just far enough
+// to refill its history.
+class Replayer : public SnapshotSource {
+public:
+    struct Status {
+        int64_t position_ns = 0;
+        int64_t length_ns = 0;
+        int speed = 1;
+        bool paused = false;
+    };
+
+    Replayer(const std::string& path, const std::vector<std::unique_ptr<Sensor>>& drivers,
+             std::function<void()> on_update);
+    ~Replayer() override;
+
+    Replayer(const Replayer&) = delete;
+    Replayer& operator=(const Replayer&) = delete;
+
+    bool ok() const { return base_ != nullptr; }
+    const std::string& error() const { return error_; }
+
+    std::shared_ptr<const SnapshotSet> latest() const override;
+    uint64_t layout() const override { return layout_.load(std::memory_order_acquire); }
+
+    void toggle_pause();
+    void toggle_speed();  // 1x <-> 10x
+    void seek(int64_t delta_ns);
+
+    Status status() const;
+
+private:
+    struct Device {
+        std::string path;
+        Sensor* driver = nullptr;
+        std::shared_ptr<const DeviceInfo> info;
+        uint32_t presence = rec::kNone;
+        std::vector<uint32_t> metrics;
+    };
+
+    void run();
+    uint32_t find_tick(int64_t t_ns) const;
+    void rebuild(uint32_t tick);
+    void apply(uint32_t tick);
+    void push_history();
+    void publish();
+
+    const rec::Header& header() const { return *reinterpret_cast<const rec::Header*>(base_); }
+    const rec::RecTick& tick_at(uint32_t i) const;
+    const rec::RecSample& sample_at(uint32_t i) const;
+    uint32_t tick_end(uint32_t tick) const;
+
+    std::string error_;
+    int fd_ = -1;
+    const char* base_ = nullptr;
+    uint64_t size_ = 0;
+    // Header counts as loaded at open; a recording still being written
+    // grows past them.
+    uint64_t ticks_ = 0;
+    uint64_t records_ = 0;
+    uint64_t strings_used_ = 0;
+    const rec::RecMetric* metrics_ = nullptr;
+    const char* strings_ = nullptr;
+
+    // Replay thread only.
+    std::vector<Device> devices_;
+    std::vector<int64_t> values_;   // per metric, current value
+    std::vector<uint32_t> latest_;  // per metric, sample holding it, kNone if unset
+    std::vector<Series*> series_;   // per metric, history slot if tracked
+    std::vector<std::string_view> keys_;  // per metric, interned
+    HistoryStore history_;
+    uint32_t tick_ = 0;
+    std::vector<bool> present_;
+
+    std::function<void()> on_update_;
+    std::atomic<uint64_t> layout_{0};
+    std::shared_ptr<const SnapshotSet> snapshot_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    Status status_;
+    int64_t seek_ns_ = 0;
+    bool seek_pending_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,317 @@
+#include "sampler.hpp"
+
+#include "profile.hpp"
+#include "rates.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+Sampler::Sampler(std::chrono::milliseconds interval, std::function<void()> on_update, unsigned threads,
+                 AlertEngine* alerts)
+    : interval_(interval), on_update_(std::move(on_update)), alerts_(alerts) {
+    if (threads == 0) {
+        threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), kMaxDefaultThreads);
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->io.set_adaptive(true);
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&Sampler::work, this, i);
+    }
+    thread_ = std::thread(&Sampler::run, this);
+}
+
+Sampler::~Sampler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+    {
+        std::lock_guard<std::mutex> lock(pass_mutex_);
+        pool_stop_ = true;
+    }
+    pass_start_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+const Snapshot* SnapshotSet::find(const std::string& path) const {
+    for (const auto& snap : devices) {
+        if (snap.path == path) return &snap;
+    }
+    return nullptr;
+}
+
+void Sampler::set_targets(std::vector<Binding> targets) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (targets == targets_) return;
+        targets_ = std::move(targets);
+        target_changed_ = true;
+    }
+    wake_.notify_all();
+}
+
+void Sampler::forget(const Binding& device) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        forgotten_.push_back(device);
+    }
+    wake_.notify_all();
+}
+
+std::shared_ptr<const SnapshotSet> Sampler::latest() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void Sampler::work(size_t self) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pass_mutex_);
+            // A helper that wakes after the pass already finished sits it
+            // out, or it could race with run() setting up the next one.
+            pass_start_.wait(lock, [&] { return pool_stop_ || (pass_id_ != seen && pending_ > 0); });
+            if (pool_stop_) return;
+            seen = pass_id_;
+            ++active_;
+        }
+        drain(self);
+        {
+            std::lock_guard<std::mutex> lock(pass_mutex_);
+            --active_;
+        }
+        pass_done_.notify_all();
+    }
+}
+
+void Sampler::drain(size_t self) {
+    Worker& worker = *workers_[self];
+    worker.io.begin_pass();
+    SampleContext ctx{worker.io, history_, pass_now_ns_};
+
+    size_t item;
+    while (next_item(self, item)) {
+        int64_t start = monotonic_ns();
+        const Binding& target = (*pass_targets_)[item];
+        Snapshot& snap = pass_set_->devices[item];
+        snap.clear();
+        snap.path = target.path;
+        snap.driver = target.driver;
+        snap.timestamp_ns = ctx.now_ns;
+        if (snap.driver) snap.driver->sample(snap.path, ctx, snap);
+        snap.version = snap.digest();
+        if (alerts_) alerts_->evaluate(item, snap);
+        taken_by_[item] = self;
+        cost_ns_[item] = monotonic_ns() - start;
+
+        std::lock_guard<std::mutex> lock(pass_mutex_);
+        if (--pending_ == 0) pass_done_.notify_all();
+    }
+}
+
+bool Sampler::next_item(size_t self, size_t& item) {
+    {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.head < own.queue.size()) {
+            own.started = true;
+            item = own.queue[own.head++];
+            return true;
+        }
+    }
+    // Steal from the back, where slow devices are queued.
+    for (size_t k = 1; k < workers_.size(); ++k) {
+        Worker& victim = *workers_[(self + k) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.started && victim.head < victim.queue.size()) {
+            item = victim.queue.back();
+            victim.queue.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Sampler::assign(const std::vector<Binding>& targets) {
+    std::vector<size_t>& slow = slow_items_;
+    slow.clear();
+    for (auto& worker : workers_) {
+        worker->queue.clear();
+        worker->head = 0;
+        worker->started = false;
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const std::string& path = targets[i].path;
+        bool is_slow = slow_.count(path) != 0;
+
+        auto own = owner_.find(path);
+        if (own == owner_.end()) {
+            // New devices go to their category's worker; slow ones are
+            // their own partition.
+            std::string key = is_slow ? path : path.substr(0, path.rfind('/'));
+            size_t home = std::hash<std::string>{}(key) % workers_.size();
+            own = owner_.emplace(path, home).first;
+        }
+        if (is_slow) {
+            slow.push_back(i);
+        } else {
+            workers_[own->second]->queue.push_back(i);
+        }
+    }
+    for (size_t i : slow) workers_[owner_[targets[i].path]]->queue.push_back(i);
+}
+
+std::shared_ptr<SnapshotSet> Sampler::recycle(size_t devices) {
+    std::shared_ptr<SnapshotSet> set;
+    for (auto& pooled : pool_) {
+        if (pooled.use_count() == 1) {
+            // Pairs with the release of the last reader letting go of it.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            set = pooled;
+            break;
+        }
+    }
+    if (!set) {
+        // Warming up, or the UI is holding on to every pooled set.
+        set = std::make_shared<SnapshotSet>();
+        if (pool_.size() < kPoolSets) pool_.push_back(set);
+    }
+    set->devices.resize(devices);
+    return set;
+}
+
+void Sampler::set_cpu_budget(double cores) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cpu_budget_ = cores;
+}
+
+void Sampler::set_idle(std::chrono::milliseconds after, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_after_ns_ = static_cast<int64_t>(after.count()) * 1000000;
+    idle_interval_ns_ = static_cast<int64_t>(interval.count()) * 1000000;
+    last_activity_ns_ = monotonic_ns();
+}
+
+void Sampler::activity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_activity_ns_ = monotonic_ns();
+    forced_idle_ = false;
+    if (!idle_) return;
+    // The wait in run() was for the idle interval; cut it short.
+    idle_ = false;
+    resume_ = true;
+    wake_.notify_one();
+}
+
+void Sampler::go_idle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    forced_idle_ = true;
+}
+
+Sampler::Pacing Sampler::pacing() const {
+    Pacing out;
+    out.period_ns = period_ns_.load(std::memory_order_relaxed);
+    out.idle = pacing_idle_.load(std::memory_order_relaxed);
+    out.cpu_usage = cpu_usage_.load(std::memory_order_relaxed);
+    return out;
+}
+
+void Sampler::run() {
+    std::vector<Binding> targets;
+    std::vector<Binding> forgotten;
+    LatencyHistogram* pass_latency = profiler().histogram("sampler:pass");
+    CpuBudget budget;
+    const int64_t interval_ns = static_cast<int64_t>(interval_.count()) * 1000000;
+
+    while (true) {
+        bool retargeted = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            int64_t now = monotonic_ns();
+            idle_ = forced_idle_ || (idle_after_ns_ > 0 && now - last_activity_ns_ >= idle_after_ns_);
+            budget.set(cpu_budget_);
+            int64_t period = budget.period(idle_ ? std::max(interval_ns, idle_interval_ns_) : interval_ns);
+            period_ns_.store(period, std::memory_order_relaxed);
+            pacing_idle_.store(idle_, std::memory_order_relaxed);
+            cpu_usage_.store(budget.usage(), std::memory_order_relaxed);
+            if (!target_changed_ && !resume_) {
+                wake_.wait_for(lock, std::chrono::nanoseconds(period),
+                               [this] { return stop_ || target_changed_ || resume_; });
+            }
+            resume_ = false;
+            if (stop_) return;
+            if (target_changed_) {
+                targets = targets_;
+                target_changed_ = false;
+                retargeted = true;
+            }
+            forgotten.swap(forgotten_);
+        }
+        if (retargeted && alerts_) alerts_->bind(targets);
+
+        // Helpers are idle between passes, so their readers can be touched here.
+        for (const auto& gone : forgotten) {
+            for (auto& worker : workers_) worker->io.forget(gone.path);
+            if (gone.driver) gone.driver->forget(gone.path);
+            history_.release(gone.path);
+            owner_.erase(gone.path);
+            slow_.erase(gone.path);
+        }
+        forgotten.clear();
+
+        if (targets.empty()) continue;
+
+        std::shared_ptr<SnapshotSet> set = recycle(targets.size());
+        {
+            ScopedTimer timer(pass_latency);
+            // No helper is in drain() and the queues are empty, so nothing
+            // can race with setting up the next pass.
+            assign(targets);
+            {
+                std::lock_guard<std::mutex> lock(pass_mutex_);
+                pass_targets_ = &targets;
+                pass_set_ = set.get();
+                pass_now_ns_ = monotonic_ns();
+                taken_by_.assign(targets.size(), 0);
+                cost_ns_.assign(targets.size(), 0);
+                pending_ = targets.size();
+                ++pass_id_;
+            }
+            pass_start_.notify_all();
+
+            drain(0);
+            std::unique_lock<std::mutex> lock(pass_mutex_);
+            pass_done_.wait(lock, [this] { return pending_ == 0 && active_ == 0; });
+        }
+
+        uint64_t version = 14695981039346656037ull;
+        for (size_t i = 0; i < targets.size(); ++i) {
+            const std::string& path = targets[i].path;
+            size_t& owner = owner_[path];
+            if (owner != taken_by_[i]) {
+                // Stolen: the thief's reader holds it now.
+                workers_[owner]->io.forget(path);
+                owner = taken_by_[i];
+            }
+            if (cost_ns_[i] >= kSlowDeviceNs) {
+                slow_.insert(path);
+            } else {
+                slow_.erase(path);
+            }
+            version = (version ^ set->devices[i].version) * 1099511628211ull;
+        }
+        set->version = version;
+
+        auto previous = latest();
+        if (previous && previous->version == set->version) continue;
+
+        std::atomic_store(&snapshot_, std::shared_ptr<const SnapshotSet>(std::move(set)));
+        if (on_update_) on_update_();
+    }
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "alerts.hpp"
+#include "bindings.hpp"
+#include "history.hpp"
+#include "sensors.hpp"
+#include "sysfs.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One sampling pass over every target, published as a unit.
+struct SnapshotSet {
+    std::vector<Snapshot> devices;
+    uint64_t version = 0;  // combined digest of all devices
+
+    const Snapshot* find(const std::string& path) const;
+};
+
+// Something other than the local Sampler that publishes SnapshotSets for the
+// UI (a remote daemon, a recording). The device list comes from the source
+// too: layout() is bumped whenever a device appears or disappears.
+class SnapshotSource {
+public:
+    virtual ~SnapshotSource() = default;
+    virtual std::shared_ptr<const SnapshotSet> latest() const = 0;
+    virtual uint64_t layout() const = 0;
+};
+
+// Polls the active targets (the selected device, or a whole category for the
+// overview) on background threads so the UI never blocks on sysfs, and
+// publishes one SnapshotSet per pass with an atomic shared_ptr swap; readers
+// grab whatever was published last. A pass whose values are unchanged is not
+// published and doesn't wake the UI, so a renderer may reuse what it built
+// for the current set.
+//
+// A pass is spread over a small pool. Each worker has its own SysfsReader
+// (so its share of the pass is one batched submission) and its own queue:
+// devices are partitioned by category, a device that was slow last pass
+// gets a partition of its own, and a worker that runs out steals from the
+// back of another's queue, so one blocking read doesn't hold up the rest.
+// Only a worker that has started its share can be stolen from: taking work
+// from one that simply hasn't woken up yet would move devices (and their
+// open attributes) between readers every pass. Stolen devices stay with the
+// thief from then on. Every worker writes
+// straight into the pass's SnapshotSet; the renderer only ever sees the
+// published result. With an AlertEngine, each device's rules are evaluated
+// by the worker that sampled it, right after sampling.
+class Sampler {
+public:
+    // threads == 0 picks one per core, up to kMaxDefaultThreads. `alerts`
+    // must outlive the sampler.
+    Sampler(std::chrono::milliseconds interval, std::function<void()> on_update, unsigned threads = 0,
+            AlertEngine* alerts = nullptr);
+    ~Sampler();
+
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    // Switch to a new set of devices; the next pass starts immediately.
+    void set_targets(std::vector<Binding> targets);
+    void set_target(const Binding& target) { set_targets({ target }); }
+
+    // Releases cached fds and driver state for a device that went away.
+    void forget(const Binding& device);
+
+    std::shared_ptr<const SnapshotSet> latest() const;
+
+    // Low-overhead mode. A budget in cores (0.005 for --max-cpu=0.5%, 0 for
+    // none) stretches the interval as CpuBudget does.
+    void set_cpu_budget(double cores);
+    // With `after` > 0, passes run every `interval` at the most once
+    // activity() hasn't been called for `after`.
+    void set_idle(std::chrono::milliseconds after, std::chrono::milliseconds interval);
+    // User input: leaves idle sampling with a pass right away, and
+    // restarts the idle timeout.
+    void activity();
+    // Drops to idle sampling without waiting for the timeout (the terminal
+    // lost focus) until the next activity().
+    void go_idle();
+
+    struct Pacing {
+        int64_t period_ns = 0;  // between passes, after budget and idling
+        bool idle = false;
+        double cpu_usage = 0;   // cores the process used, smoothed
+    };
+    Pacing pacing() const;
+
+private:
+    static constexpr unsigned kMaxDefaultThreads = 4;
+    static constexpr int64_t kSlowDeviceNs = 2000000;
+
+    // Worker 0 is the thread running run(); the others only sample.
+    struct Worker {
+        SysfsReader io;
+        std::mutex mutex;
+        // Indices into the current pass's targets; the owner takes from
+        // `head`, thieves from the back. A vector rather than a deque so a
+        // steady pass doesn't allocate.
+        std::vector<size_t> queue;
+        size_t head = 0;
+        bool started = false;  // has taken an item of its own this pass
+        std::thread thread;
+    };
+
+    void run();
+    void work(size_t self);
+    void drain(size_t self);
+    bool next_item(size_t self, size_t& item);
+    void assign(const std::vector<Binding>& targets);
+    std::shared_ptr<SnapshotSet> recycle(size_t devices);
+
+    std::chrono::milliseconds interval_;
+    std::function<void()> on_update_;
+    AlertEngine* alerts_;
+
+    HistoryStore history_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // The current pass. Written by run() under pass_mutex_ while every
+    // helper is idle; sampled items are counted down in pending_.
+    std::mutex pass_mutex_;
+    std::condition_variable pass_start_;
+    std::condition_variable pass_done_;
+    uint64_t pass_id_ = 0;
+    size_t pending_ = 0;
+    size_t active_ = 0;  // helpers inside drain()
+    bool pool_stop_ = false;
+    const std::vector<Binding>* pass_targets_ = nullptr;
+    SnapshotSet* pass_set_ = nullptr;
+    int64_t pass_now_ns_ = 0;
+    std::vector<size_t> taken_by_;  // item -> worker that sampled it
+    std::vector<int64_t> cost_ns_;  // item -> time spent sampling it
+
+    // run() only.
+    static constexpr size_t kPoolSets = 4;
+    std::map<std::string, size_t> owner_;  // device path -> worker whose reader holds it
+    std::set<std::string> slow_;
+    std::vector<size_t> slow_items_;
+    // Sets handed out by recycle(); one is reused once neither the UI nor
+    // snapshot_ holds it, so a steady pass refills buffers it already has.
+    std::vector<std::shared_ptr<SnapshotSet>> pool_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<Binding> targets_;
+    bool target_changed_ = false;
+    std::vector<Binding> forgotten_;
+    bool stop_ = false;
+    double cpu_budget_ = 0;
+    int64_t idle_after_ns_ = 0;
+    int64_t idle_interval_ns_ = 0;
+    int64_t last_activity_ns_ = 0;
+    bool forced_idle_ = false;
+    bool idle_ = false;
+    bool resume_ = false;  // a pass is due now: idle sampling just ended
+
+    // Written by run(), for pacing().
+    std::atomic<int64_t> period_ns_{0};
+    std::atomic<bool> pacing_idle_{false};
+    std::atomic<double> cpu_usage_{0};
+
+    std::shared_ptr<const SnapshotSet> snapshot_;
+    std::thread thread_;
+};
@@ -0,0 +1,117 @@
+// How sampling and drawing scale with the device count, over synthetic
+// device trees (backend.hpp) far bigger than any test machine's:
+//   ./kmap_scale --benchmark_counters_tabular=true
+// Each size gets N net interfaces, N/8 thermal zones and N/32 hwmon chips of
+// 8 channels, a fifth of them moving; per_device is the cost of one tick
+// or frame divided by N, which stays flat while the cost scales linearly.
+
+#include <benchmark/benchmark.h>
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backend.hpp"
+#include "bindings.hpp"
+#include "categories.hpp"
+#include "history.hpp"
+#include "rates.hpp"
+#include "sensors.hpp"
+#include "sysfs.hpp"
+
+namespace {
+
+// Installs a synthetic tree of `n` net devices and binds it like discovery.
+struct Tree {
+    std::vector<std::unique_ptr<Sensor>> drivers = make_default_drivers();
+    std::vector<Binding> bindings;
+
+    explicit Tree(size_t n) {
+        SyntheticBackend::Spec spec;
+        spec.net = n;
+        spec.thermal = n / 8;
+        spec.hwmon = n / 32;
+        set_attr_backend(std::make_unique<SyntheticBackend>(spec));
+        bindings = bind_categories(default_categories(), drivers);
+    }
+    ~Tree() { set_attr_backend(std::make_unique<SysfsBackend>()); }
+};
+
+void set_per_device(benchmark::State& state, size_t devices) {
+    state.counters["devices"] = static_cast<double>(devices);
+    state.counters["per_device"] = benchmark::Counter(static_cast<double>(devices),
+                                                      benchmark::Counter::kIsIterationInvariantRate |
+                                                          benchmark::Counter::kInvert);
+}
+
+// One sampler tick: an adaptive pass over every bound device, as each
+// sampler worker runs it.
+void BM_SamplerTick(benchmark::State& state) {
+    Tree tree(static_cast<size_t>(state.range(0)));
+    SysfsReader io;
+    io.set_adaptive(true);
+    HistoryStore history;
+    std::vector<Snapshot> snaps(tree.bindings.size());
+    auto tick = [&] {
+        SampleContext ctx{io, history, monotonic_ns()};
+        io.begin_pass();
+        for (size_t i = 0; i < tree.bindings.size(); ++i) {
+            const Binding& b = tree.bindings[i];
+            Snapshot& snap = snaps[i];
+            snap.clear();
+            snap.path = b.path;
+            snap.driver = b.driver;
+            snap.timestamp_ns = ctx.now_ns;
+            b.driver->sample(b.path, ctx, snap);
+            snap.version = snap.digest();
+        }
+    };
+    // The first tick opens every attribute; steady state is what's timed.
+    tick();
+
+    for (auto _ : state) {
+        tick();
+        benchmark::DoNotOptimize(snaps.data());
+    }
+    set_per_device(state, tree.bindings.size());
+    state.counters["open_fds"] = static_cast<double>(io.open_count());
+}
+BENCHMARK(BM_SamplerTick)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+
+// One overview frame: every device's card, laid out like main.cpp's grid
+// and rendered into a terminal-sized screen.
+void BM_OverviewFrame(benchmark::State& state) {
+    using namespace ftxui;
+    Tree tree(static_cast<size_t>(state.range(0)));
+    SysfsReader io;
+    HistoryStore history;
+    SampleContext ctx{io, history, monotonic_ns()};
+    std::vector<Snapshot> snaps;
+    for (const Binding& b : tree.bindings) {
+        Snapshot& snap = snaps.emplace_back();
+        snap.path = b.path;
+        snap.driver = b.driver;
+        snap.timestamp_ns = ctx.now_ns;
+        b.driver->sample(b.path, ctx, snap);
+    }
+
+    auto screen = Screen::Create(Dimension::Fixed(240), Dimension::Fixed(70));
+    for (auto _ : state) {
+        Elements cards;
+        cards.reserve(snaps.size());
+        for (const auto& snap : snaps) {
+            std::string name = snap.path.substr(snap.path.rfind('/') + 1);
+            cards.push_back(window(text(" " + name + " "), snap.driver->summary(snap)) | size(WIDTH, EQUAL, 26));
+        }
+        Render(screen, hflow(cards));
+        benchmark::DoNotOptimize(screen);
+    }
+    set_per_device(state, snaps.size());
+}
+BENCHMARK(BM_OverviewFrame)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "backend.hpp"
+#include "driver.hpp"
+#include "rates.hpp"
+#include "units.hpp"
+
+// Compile-time attribute schemas for drivers whose devices expose a fixed
+// set of sysfs attributes. A driver lists its fields once:
+//
+//   inline constexpr char kCapacity[] = "capacity";
+//   inline constexpr char kStatus[] = "status";
+//   using PowerSchema = Schema<Number<kCapacity, Percent>, Text<kStatus>>;
+//
+// and SchemaSensor generates the rest: the probe (the first field's
+// attribute exists), the per-device state (one handle per field, opened once
+// per reader), and a sampling pass that reads every field straight into the
+// snapshot. Fields are a tuple walked by fold expressions, so which reads a
+// device gets, and under which keys, is fixed when the driver is compiled;
+// nothing is looked up or dispatched per field at run time. Renderers read
+// the snapshot back through the same field types instead of literal keys.
+//
+// Snapshot keys are the attribute's last path component ("statistics/rx_bytes"
+// -> "rx_bytes"), views of the static name array, so they live as long as the
+// process and end in a NUL the way Snapshot::digest() expects.
+namespace schema {
+
+// Units of an integer attribute; raw / divisor is the value in `unit`.
+struct Raw {
+    static constexpr const char* unit = "";
+    static constexpr int64_t divisor = 1;
+};
+struct Millidegrees {
+    static constexpr const char* unit = "°C";
+    static constexpr int64_t divisor = 1000;
+};
+struct Percent {
+    static constexpr const char* unit = "%";
+    static constexpr int64_t divisor = 1;
+};
+// power_supply class: µW, µA, µV, µWh.
+struct Microwatts {
+    static constexpr const char* unit = "W";
+    static constexpr int64_t divisor = 1000000;
+};
+struct Microamps {
+    static constexpr const char* unit = "A";
+    static constexpr int64_t divisor = 1000000;
+};
+struct Microvolts {
+    static constexpr const char* unit = "V";
+    static constexpr int64_t divisor = 1000000;
+};
+struct MicrowattHours {
+    static constexpr const char* unit = "Wh";
+    static constexpr int64_t divisor = 1000000;
+};
+
+enum Flags : unsigned {
+    kHistory = 1,  // keep a Series of the value (of the rate, for counters)
+};
+
+constexpr std::string_view basename(std::string_view attr) {
+    size_t slash = attr.rfind('/');
+    return slash == std::string_view::npos ? attr : attr.substr(slash + 1);
+}
+
+// "<basename>/s", NUL-terminated, in static storage.
+template <const char* Attr>
+struct PerSecond {
+    static constexpr std::string_view base = basename(Attr);
+    static constexpr std::array<char, base.size() + 3> chars = [] {
+        std::array<char, base.size() + 3> out{};
+        for (size_t i = 0; i < base.size(); ++i) out[i] = base[i];
+        out[base.size()] = '/';
+        out[base.size() + 1] = 's';
+        return out;
+    }();
+    static constexpr std::string_view value{chars.data(), base.size() + 2};
+};
+
+// An integer attribute in `Unit`s.
+template <const char* Attr, typename Unit = Raw, unsigned Options = 0>
+struct Number {
+    static constexpr std::string_view attr = Attr;
+    static constexpr std::string_view key = basename(Attr);
+
+    struct State {
+        SysfsReader::Handle handle = nullptr;
+        Series* series = nullptr;
+    };
+
+    static void open(State& s, const std::string& path, SampleContext& ctx) {
+        s.handle = ctx.io.open(path, attr);
+        if (Options & kHistory) s.series = ctx.history.series(path, key);
+    }
+
+    static void read(State& s, SampleContext& ctx, Snapshot& snap) {
+        long long value = 0;
+        if (!ctx.io.read_int(s.handle, value)) return;
+        snap.set_number(key, value);
+        if (Options & kHistory) {
+            if (s.series) s.series->push(value);
+            snap.track(key, s.series);
+        }
+    }
+
+    static bool get(const Snapshot& snap, int64_t& out) { return snap.number(key, out); }
+    static const Series* series(const Snapshot& snap) { return snap.series(key); }
+
+    // "45.2 °C" in the field's unit, or "n/a".
+    static std::string format(const Snapshot& snap) {
+        int64_t value = 0;
+        return get(snap, value) ? format_scaled(value, Unit::divisor, Unit::unit) : "n/a";
+    }
+};
+
+// A short string attribute (state names, addresses), stored as read.
+template <const char* Attr>
+struct Text {
+    static constexpr std::string_view attr = Attr;
+    static constexpr std::string_view key = basename(Attr);
+    static constexpr size_t kMaxLength = 64;
+
+    struct State {
+        SysfsReader::Handle handle = nullptr;
+    };
+
+    static void open(State& s, const std::string& path, SampleContext& ctx) { s.handle = ctx.io.open(path, attr); }
+
+    static void read(State& s, SampleContext& ctx, Snapshot& snap) {
+        char buf[kMaxLength];
+        int n = ctx.io.read(s.handle, buf, sizeof(buf));
+        snap.set(key, std::string_view(buf, n > 0 ? n : 0));
+    }
+
+    static const std::string& get(const Snapshot& snap) { return snap.get(key); }
+};
+
+// A monotonic counter: the raw value under its key and, from the second
+// fresh read on, the smoothed per-second rate under "<key>/s".
+template <const char* Attr, unsigned Options = 0>
+struct Counter {
+    static constexpr std::string_view attr = Attr;
+    static constexpr std::string_view key = basename(Attr);
+    static constexpr std::string_view rate_key = PerSecond<Attr>::value;
+
+    struct State {
+        SysfsReader::Handle handle = nullptr;
+        RateMeter meter;
+        Series* series = nullptr;  // of the rate
+    };
+
+    static void open(State& s, const std::string& path, SampleContext& ctx) {
+        s.handle = ctx.io.open(path, attr);
+        if (Options & kHistory) s.series = ctx.history.series(path, rate_key);
+    }
+
+    static void read(State& s, SampleContext& ctx, Snapshot& snap) {
+        unsigned long long value = 0;
+        if (!ctx.io.read_u64(s.handle, value)) return;
+        snap.set_number(key, static_cast<int64_t>(value));
+        if (!s.meter.update(value, ctx.now_ns, ctx.io.fresh())) return;
+        int64_t rate = static_cast<int64_t>(s.meter.rate() + 0.5);
+        snap.set_number(rate_key, rate);
+        if (Options & kHistory) {
+            if (s.series) s.series->push(rate);
+            snap.track(rate_key, s.series);
+        }
+    }
+
+    static bool get(const Snapshot& snap, int64_t& out) { return snap.number(key, out); }
+    static bool rate(const Snapshot& snap, int64_t& out) { return snap.number(rate_key, out); }
+    static const Series* series(const Snapshot& snap) { return snap.series(rate_key); }
+};
+
+// Power integrated over time, derived from fields read earlier in the same
+// pass: `Power` (µW), or `Current` (µA) times `Voltage` (µV) for supplies
+// that only report those. Adds "power" (µW, with history), "power_avg" (µW
+// over EnergyMeter::kWindowNs) and "energy" (µJ since the device was first
+// sampled). Reads nothing itself, so it must come after its sources.
+template <typename Power, typename Current, typename Voltage>
+struct Energy {
+    static constexpr std::string_view key = "power";
+    static constexpr std::string_view average_key = "power_avg";
+    static constexpr std::string_view energy_key = "energy";
+
+    struct State {
+        EnergyMeter meter;
+        Series* series = nullptr;
+    };
+
+    static void open(State& s, const std::string& path, SampleContext& ctx) {
+        s.series = ctx.history.series(path, key);
+    }
+
+    static void read(State& s, SampleContext& ctx, Snapshot& snap) {
+        int64_t power = 0;
+        if (!Power::get(snap, power)) {
+            int64_t current = 0, voltage = 0;
+            if (!Current::get(snap, current) || !Voltage::get(snap, voltage)) return;
+            power = current * voltage / 1000000;  // µA·µV = pW
+        }
+        // current_now is negative while discharging on some firmware.
+        if (power < 0) power = -power;
+        s.meter.add_power(power, ctx.now_ns);
+        snap.set_number(key, power);
+        int64_t average = 0;
+        if (s.meter.average(average)) snap.set_number(average_key, average);
+        snap.set_number(energy_key, s.meter.energy_uj());
+        if (s.series) s.series->push(power);
+        snap.track(key, s.series);
+    }
+
+    static bool get(const Snapshot& snap, int64_t& out) { return snap.number(key, out); }
+    static bool average(const Snapshot& snap, int64_t& out) { return snap.number(average_key, out); }
+    static bool energy(const Snapshot& snap, int64_t& out) { return snap.number(energy_key, out); }
+    static const Series* series(const Snapshot& snap) { return snap.series(key); }
+};
+
+}  // namespace schema
+
+// The fields of one driver, in sampling order; the first is the probe.
+template <typename... Fields>
+struct Schema {
+    static_assert(sizeof...(Fields) > 0, "a schema needs at least its probe field");
+    using Probe = std::tuple_element_t<0, std::tuple<Fields...>>;
+};
+
+// Sensor generated from a Schema. Drivers derive from it for their name and
+// renderers, and may override describe() for the DeviceInfo, which is built
+// once per device.
+template <typename S>
+class SchemaSensor;
+
+template <typename... Fields>
+class SchemaSensor<Schema<Fields...>> : public Sensor {
+public:
+    bool is_compatible(const std::string& path) override {
+        std::string probe = path;
+        probe.append("/").append(Schema<Fields...>::Probe::attr);
+        return attr_backend().exists(probe);
+    }
+
+    void sample(const std::string& path, SampleContext& ctx, Snapshot& snap) override {
+        constexpr auto fields = std::index_sequence_for<Fields...>{};
+        State& state = states_.get(path, ctx, [&](State& s) {
+            if (!s.info) s.info = describe(path);
+            open_all(s, path, ctx, fields);
+        });
+        snap.info = state.info;
+        read_all(state, ctx, snap, fields);
+    }
+
+    void forget(const std::string& path) override { states_.forget(path); }
+
+protected:
+    virtual std::shared_ptr<const DeviceInfo> describe(const std::string& path) {
+        (void)path;
+        return nullptr;
+    }
+
+private:
+    struct State {
+        const SysfsReader* io = nullptr;
+        std::shared_ptr<const DeviceInfo> info;
+        std::tuple<typename Fields::State...> fields;
+    };
+
+    template <size_t... I>
+    static void open_all(State& s, const std::string& path, SampleContext& ctx, std::index_sequence<I...>) {
+        (Fields::open(std::get<I>(s.fields), path, ctx), ...);
+    }
+
+    template <size_t... I>
+    static void read_all(State& s, SampleContext& ctx, Snapshot& snap, std::index_sequence<I...>) {
+        (Fields::read(std::get<I>(s.fields), ctx, snap), ...);
+    }
+
+    DeviceStates<State> states_;
+};
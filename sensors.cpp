@@ -0,0 +1,815 @@
+#include "sensors.hpp"
+
+#include "backend.hpp"
+#include "units.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+using namespace ftxui;
+
+// Autoscaled line graph of a Series, newest sample at the right edge. With
+// `deltas` it plots the change between consecutive samples, which is what a
+// monotonic counter needs.
+static Element history_graph(const Series* series, bool deltas) {
+    if (!series) return emptyElement();
+    return graph([series, deltas](int width, int height) {
+        std::vector<int> out(std::max(width, 0), 0);
+        int64_t buf[Series::kCapacity];
+        size_t want = std::min<size_t>(width + (deltas ? 1 : 0), Series::kCapacity);
+        size_t n = series->copy_latest(buf, want);
+        if (deltas) {
+            for (size_t i = 1; i < n; ++i) buf[i - 1] = buf[i] - buf[i - 1];
+            n = n ? n - 1 : 0;
+        }
+        if (n == 0 || height <= 0) return out;
+
+        auto [lo, hi] = std::minmax_element(buf, buf + n);
+        int64_t min = *lo;
+        int64_t range = *hi - *lo;
+        size_t offset = out.size() - n;
+        for (size_t i = 0; i < n; ++i) {
+            out[offset + i] = range ? static_cast<int>((buf[i] - min) * height / range) : height / 2;
+        }
+        return out;
+    });
+}
+
+void Snapshot::clear() {
+    path.clear();
+    driver = nullptr;
+    info.reset();
+    timestamp_ns = 0;
+    version = 0;
+    for (auto& kv : values) spare_.push_back(std::move(kv.second));
+    values.clear();
+    numbers.clear();
+    history.clear();
+}
+
+// FNV-1a over paths, keys and values.
+uint64_t Snapshot::digest() const {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < len; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    mix(path.data(), path.size());
+    for (const auto& kv : values) {
+        mix(kv.first.data(), kv.first.size() + 1);
+        mix(kv.second.data(), kv.second.size() + 1);
+    }
+    for (const auto& kv : numbers) {
+        mix(kv.first.data(), kv.first.size() + 1);
+        mix(&kv.second, sizeof(kv.second));
+    }
+    return h;
+}
+
+void Snapshot::set(std::string_view key, std::string_view value) {
+    std::string buf;
+    if (!spare_.empty()) {
+        buf = std::move(spare_.back());
+        spare_.pop_back();
+    }
+    buf.assign(value);
+    values.emplace_back(key, std::move(buf));
+}
+
+const std::string& Snapshot::get(std::string_view key) const {
+    static const std::string empty;
+    for (const auto& kv : values) {
+        if (kv.first == key) return kv.second;
+    }
+    return empty;
+}
+
+void Snapshot::set_number(std::string_view key, int64_t value) {
+    numbers.emplace_back(key, value);
+}
+
+bool Snapshot::number(std::string_view key, int64_t& out) const {
+    for (const auto& kv : numbers) {
+        if (kv.first == key) {
+            out = kv.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Snapshot::track(std::string_view key, const Series* series) {
+    if (series) history.emplace_back(key, series);
+}
+
+const Series* Snapshot::series(std::string_view key) const {
+    for (const auto& kv : history) {
+        if (kv.first == key) return kv.second;
+    }
+    return nullptr;
+}
+
+Element Sensor::summary(const Snapshot& snap) {
+    if (snap.values.empty()) return text("-") | color(Color::GrayLight);
+    return text(snap.values.front().second);
+}
+
+// --- Thermal ---
+
+// Type and critical trip point never change, so they are read once per zone.
+std::shared_ptr<const DeviceInfo> ThermalSensor::describe(const std::string& path) {
+    auto info = std::make_shared<DeviceInfo>();
+    info->name = read_file(path + "/type");
+
+    ChannelInfo ch;
+    ch.key = thermal::Temp::key;
+    ch.label = info->name.empty() ? "temp" : info->name;
+    ch.unit = "°C";
+    ch.divisor = 1000;
+    for (int trip = 0;; ++trip) {
+        std::string prefix = path + "/trip_point_" + std::to_string(trip);
+        std::string type = read_file(prefix + "_type");
+        if (type.empty()) break;
+        int64_t crit = 0;
+        if (type == "critical" && parse_i64(read_file(prefix + "_temp"), crit) && crit > 0) {
+            ch.crit = crit;
+            ch.has_crit = true;
+            break;
+        }
+    }
+    info->channels.push_back(std::move(ch));
+    return info;
+}
+
+Element ThermalSensor::render(const Snapshot& snap) {
+    int64_t millideg = 0;
+    if (!thermal::Temp::get(snap, millideg)) return text("Error reading temp");
+    bool hot = millideg > 60000;
+
+    // Build the UI component
+    auto content = hbox({
+        text("Temperature: ") | bold,
+        text(thermal::Temp::format(snap)) | color(hot ? Color::Red : Color::Green)
+    });
+
+    Elements lines = { content };
+
+    // Add sensor type if available
+    if (snap.info && !snap.info->name.empty()) lines.push_back(text("Sensor Type: " + snap.info->name));
+    if (snap.info && snap.info->channels.front().has_crit) {
+        lines.push_back(text("Critical: " + format_scaled(snap.info->channels.front().crit, 1000, "°C"))
+                        | color(Color::GrayLight));
+    }
+
+    if (const Series* series = thermal::Temp::series(snap)) {
+        lines.push_back(separator());
+        lines.push_back(history_graph(series, false)
+            | color(hot ? Color::Red : Color::Green)
+            | size(HEIGHT, EQUAL, 8));
+    }
+    return vbox(lines);
+}
+
+Element ThermalSensor::summary(const Snapshot& snap) {
+    int64_t millideg = 0;
+    if (!thermal::Temp::get(snap, millideg)) return text("n/a") | color(Color::GrayLight);
+
+    return vbox({
+        text(thermal::Temp::format(snap)) | bold | color(millideg > 60000 ? Color::Red : Color::Green),
+        text(snap.info ? snap.info->name : "") | color(Color::GrayLight)
+    });
+}
+
+// --- Network ---
+
+Element NetworkSensor::render(const Snapshot& snap) {
+    const std::string& state = net::Operstate::get(snap);
+    auto state_color = (state == "up") ? Color::Green : Color::Red;
+
+    Elements lines;
+    lines.push_back(hbox({
+        text("Link State: "),
+        text(state) | bold | color(state_color)
+    }));
+
+    const std::string& mac = net::Address::get(snap);
+    if (!mac.empty()) lines.push_back(text("MAC: " + mac));
+
+    int64_t rx_total = 0;
+    if (net::RxBytes::get(snap, rx_total)) {
+        lines.push_back(text("Data Rx: " + std::to_string(rx_total) + " bytes"));
+    }
+
+    int64_t rx_bps = 0, tx_bps = 0, rx_pps = 0, tx_pps = 0;
+    bool have_rates = net::RxBytes::rate(snap, rx_bps) && net::TxBytes::rate(snap, tx_bps);
+    if (!have_rates) {
+        lines.push_back(text("Measuring throughput...") | color(Color::GrayLight));
+        return vbox(lines);
+    }
+    net::RxPackets::rate(snap, rx_pps);
+    net::TxPackets::rate(snap, tx_pps);
+
+    lines.push_back(separator());
+    lines.push_back(hbox({
+        text("Rx: ") | bold,
+        text(format_rate(rx_bps, "B")) | color(Color::Cyan),
+        text("  " + format_rate(rx_pps, "pkt")) | color(Color::GrayLight)
+    }));
+    lines.push_back(history_graph(net::RxBytes::series(snap), false) | color(Color::Cyan) | size(HEIGHT, EQUAL, 6));
+    lines.push_back(hbox({
+        text("Tx: ") | bold,
+        text(format_rate(tx_bps, "B")) | color(Color::Magenta),
+        text("  " + format_rate(tx_pps, "pkt")) | color(Color::GrayLight)
+    }));
+    lines.push_back(history_graph(net::TxBytes::series(snap), false) | color(Color::Magenta) | size(HEIGHT, EQUAL, 6));
+
+    int64_t dropped = 0, errors = 0, dropped_rate = 0, errors_rate = 0;
+    net::RxDropped::get(snap, dropped);
+    net::RxErrors::get(snap, errors);
+    net::RxDropped::rate(snap, dropped_rate);
+    net::RxErrors::rate(snap, errors_rate);
+    lines.push_back(text("Rx dropped: " + std::to_string(dropped) + " (" + std::to_string(dropped_rate) + "/s)"
+                         + "  errors: " + std::to_string(errors) + " (" + std::to_string(errors_rate) + "/s)")
+                    | color(dropped_rate || errors_rate ? Color::Red : Color::GrayLight));
+
+    return vbox(lines);
+}
+
+Element NetworkSensor::summary(const Snapshot& snap) {
+    const std::string& state = net::Operstate::get(snap);
+    int64_t rx_bps = 0, tx_bps = 0;
+    bool have_rates = net::RxBytes::rate(snap, rx_bps) && net::TxBytes::rate(snap, tx_bps);
+    return vbox({
+        text(state) | bold | color(state == "up" ? Color::Green : Color::Red),
+        have_rates ? text("↓" + format_rate(rx_bps, "B") + " ↑" + format_rate(tx_bps, "B"))
+                   : text("measuring...") | color(Color::GrayLight)
+    });
+}
+
+// --- Power ---
+
+static std::string capacity_text(const Snapshot& snap) {
+    int64_t capacity = 0;
+    return power::Capacity::get(snap, capacity) ? std::to_string(capacity) + "%" : "n/a";
+}
+
+// "152.3 J", with watt-hours once it's worth it.
+static std::string energy_text(int64_t microjoules) {
+    std::string out = format_scaled(microjoules, 1000000, "J");
+    if (microjoules >= 3600000000) out += " (" + format_scaled(microjoules / 3600, 1000000, "Wh") + ")";
+    return out;
+}
+
+Element PowerSensor::render(const Snapshot& snap) {
+    Elements lines = {
+        text("Battery Level: " + capacity_text(snap)) | bold,
+        text("Status: " + power::Status::get(snap))
+    };
+    int64_t value = 0;
+    if (power::EnergyNow::get(snap, value)) lines.push_back(text("Stored: " + power::EnergyNow::format(snap)));
+    if (power::VoltageNow::get(snap, value) || power::CurrentNow::get(snap, value)) {
+        lines.push_back(text("Voltage: " + power::VoltageNow::format(snap) + "  Current: " +
+                             power::CurrentNow::format(snap)) | color(Color::GrayLight));
+    }
+
+    int64_t watts = 0;
+    if (!power::Energy::get(snap, watts)) return vbox(lines);
+    int64_t average = 0, energy = 0;
+    std::string power_line = format_scaled(watts, 1000000, "W");
+    if (power::Energy::average(snap, average)) power_line += "  (avg " + format_scaled(average, 1000000, "W") + ")";
+    power::Energy::energy(snap, energy);
+
+    lines.push_back(separator());
+    lines.push_back(hbox({ text("Power: ") | bold, text(power_line) | color(Color::Yellow) }));
+    lines.push_back(text("Energy this session: " + energy_text(energy)));
+    lines.push_back(history_graph(power::Energy::series(snap), false) | color(Color::Yellow) | size(HEIGHT, EQUAL, 6));
+    return vbox(lines);
+}
+
+Element PowerSensor::summary(const Snapshot& snap) {
+    std::string status = power::Status::get(snap);
+    int64_t watts = 0;
+    if (power::Energy::get(snap, watts)) status += "  " + format_scaled(watts, 1000000, "W");
+    return vbox({
+        text(capacity_text(snap)) | bold,
+        text(status) | color(Color::GrayLight)
+    });
+}
+
+// --- RAPL ---
+
+bool RaplSensor::is_compatible(const std::string& path) {
+    return attr_backend().exists(path + "/energy_uj");
+}
+
+void RaplSensor::sample(const std::string& path, SampleContext& ctx, Snapshot& snap) {
+    State& state = states_.get(path, ctx, [&](State& s) {
+        if (!s.info) {
+            auto info = std::make_shared<DeviceInfo>();
+            info->name = read_file(path + "/name");
+            s.info = std::move(info);
+            s.zone = poller_.watch(path);
+        }
+        s.series = ctx.history.series(path, "power");
+    });
+    snap.info = state.info;
+    if (!state.zone) return;
+
+    RaplPoller::Reading reading;
+    poller_.take(state.zone, ctx.now_ns, reading);
+    snap.set_number("energy", reading.energy_uj);
+    if (!reading.ready) return;
+    snap.set_number("power", reading.power_uw);
+    snap.set_number("power_peak", reading.peak_uw);
+    snap.set_number("power_avg", reading.average_uw);
+    if (state.series) state.series->push(reading.power_uw);
+    snap.track("power", state.series);
+}
+
+void RaplSensor::forget(const std::string& path) {
+    poller_.unwatch(path);
+    states_.forget(path);
+}
+
+Element RaplSensor::render(const Snapshot& snap) {
+    const std::string& zone = snap.info ? snap.info->name : "";
+    Elements lines = { hbox({ text("Zone: ") | bold, text(zone) }) };
+    int64_t energy = 0;
+    if (!snap.number("energy", energy)) {
+        lines.push_back(text("energy_uj is not readable (root only since Linux 5.10)") | color(Color::GrayLight));
+        return vbox(lines);
+    }
+
+    int64_t power = 0, peak = 0, average = 0;
+    lines.push_back(separator());
+    if (snap.number("power", power) && snap.number("power_peak", peak) && snap.number("power_avg", average)) {
+        lines.push_back(hbox({
+            text("Power: ") | bold,
+            text(format_scaled(power, 1000000, "W")) | color(Color::Yellow),
+            text("  peak " + format_scaled(peak, 1000000, "W") + "  (avg " + format_scaled(average, 1000000, "W") + ")")
+                | color(Color::GrayLight)
+        }));
+    } else {
+        lines.push_back(text("Measuring power...") | color(Color::GrayLight));
+    }
+    lines.push_back(text("Energy this session: " + energy_text(energy)));
+    lines.push_back(history_graph(snap.series("power"), false) | color(Color::Yellow) | size(HEIGHT, EQUAL, 6));
+    return vbox(lines);
+}
+
+Element RaplSensor::summary(const Snapshot& snap) {
+    int64_t power = 0;
+    return vbox({
+        text(snap.info ? snap.info->name : "") | bold,
+        snap.number("power", power) ? text(format_scaled(power, 1000000, "W"))
+                                    : text("n/a") | color(Color::GrayLight)
+    });
+}
+
+// --- Hwmon ---
+
+namespace {
+struct HwmonKind {
+    const char* prefix;
+    const char* unit;
+    int64_t divisor;
+};
+// sysfs-interface units: millidegree, RPM, millivolt, microwatt.
+const HwmonKind kHwmonKinds[] = {
+    {"temp", "°C", 1000},
+    {"fan", "RPM", 1},
+    {"in", "V", 1000},
+    {"power", "W", 1000000},
+};
+
+// "temp3_input" -> kind 0, channel 3.
+bool parse_hwmon_input(const std::string& file, int& kind, int& channel) {
+    const std::string suffix = "_input";
+    if (file.size() <= suffix.size() || file.compare(file.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return false;
+    }
+    for (int k = 0; k < static_cast<int>(std::size(kHwmonKinds)); ++k) {
+        size_t len = std::strlen(kHwmonKinds[k].prefix);
+        if (file.compare(0, len, kHwmonKinds[k].prefix) != 0) continue;
+        const char* first = file.data() + len;
+        const char* last = file.data() + file.size() - suffix.size();
+        auto result = std::from_chars(first, last, channel);
+        if (result.ec != std::errc() || result.ptr != last) return false;
+        kind = k;
+        return true;
+    }
+    return false;
+}
+}
+
+bool HwmonSensor::is_compatible(const std::string& path) {
+    return attr_backend().exists(path + "/name");
+}
+
+HwmonSensor::Index HwmonSensor::build_index(const std::string& path, SampleContext& ctx) {
+    struct Found {
+        int kind;
+        int channel;
+        std::string stem;  // "temp3"
+    };
+    std::vector<Found> found;
+    for (const std::string& file : attr_backend().list(path)) {
+        int kind = 0, channel = 0;
+        if (parse_hwmon_input(file, kind, channel)) {
+            found.push_back({kind, channel, file.substr(0, file.size() - 6)});
+        }
+    }
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+        return a.kind != b.kind ? a.kind < b.kind : a.channel < b.channel;
+    });
+
+    auto info = std::make_shared<DeviceInfo>();
+    info->name = ctx.io.read_string(path, "name");
+
+    Index index;
+    index.io = &ctx.io;
+    for (const auto& f : found) {
+        SysfsReader::Handle input = ctx.io.open(path, f.stem + "_input");
+        if (!input) continue;
+
+        ChannelInfo ch;
+        ch.key = f.stem;
+        ch.label = read_file(path + "/" + f.stem + "_label");
+        if (ch.label.empty()) ch.label = f.stem;
+        ch.unit = kHwmonKinds[f.kind].unit;
+        ch.divisor = kHwmonKinds[f.kind].divisor;
+        int64_t crit = 0;
+        if (parse_i64(read_file(path + "/" + f.stem + "_crit"), crit) && crit > 0) {
+            ch.crit = crit;
+            ch.has_crit = true;
+        }
+
+        index.keys.push_back(paths().key(ch.key));
+        info->channels.push_back(std::move(ch));
+        index.inputs.push_back(input);
+        index.series.push_back(ctx.history.series(path, f.stem));
+    }
+    index.info = std::move(info);
+    return index;
+}
+
+void HwmonSensor::sample(const std::string& path, SampleContext& ctx, Snapshot& snap) {
+    // A device that moved to another sampler worker is indexed again
+    // through the new worker's reader.
+    const Index& index = index_.get(path, ctx, [&](Index& s) { s = build_index(path, ctx); });
+
+    snap.info = index.info;
+    for (size_t i = 0; i < index.inputs.size(); ++i) {
+        long long raw = 0;
+        if (!ctx.io.read_int(index.inputs[i], raw)) continue;
+        snap.set_number(index.keys[i], raw);
+        if (index.series[i]) index.series[i]->push(raw);
+    }
+}
+
+void HwmonSensor::forget(const std::string& path) {
+    index_.forget(path);
+}
+
+Element HwmonSensor::render(const Snapshot& snap) {
+    if (!snap.info) return text("Error reading hwmon device");
+    const DeviceInfo& info = *snap.info;
+    if (info.channels.empty()) return text("No readable channels") | color(Color::GrayLight);
+
+    std::vector<Elements> rows;
+    for (const auto& ch : info.channels) {
+        int64_t raw = 0;
+        bool ok = snap.number(ch.key, raw);
+        Element value = ok ? text(format_scaled(raw, ch.divisor, ch.unit)) : text("n/a") | color(Color::GrayLight);
+
+        Element bar = text("");
+        if (ok && ch.has_crit) {
+            float ratio = std::clamp(static_cast<float>(raw) / ch.crit, 0.0f, 1.0f);
+            bar = gauge(ratio) | color(ratio > 0.85f ? Color::Red : Color::Green) | size(WIDTH, EQUAL, 16);
+            value = value | color(ratio > 0.85f ? Color::Red : Color::Green);
+        }
+        rows.push_back({ text(ch.label + "  ") | bold, value, text("  "), bar });
+    }
+
+    return vbox({
+        hbox({ text("Chip: ") | bold, text(info.name) }),
+        separator(),
+        gridbox(rows)
+    });
+}
+
+Element HwmonSensor::summary(const Snapshot& snap) {
+    if (!snap.info) return text("n/a") | color(Color::GrayLight);
+
+    // Hottest temperature channel, if any.
+    int64_t hottest = 0;
+    const ChannelInfo* hottest_ch = nullptr;
+    for (const auto& ch : snap.info->channels) {
+        int64_t raw = 0;
+        if (std::strcmp(ch.unit, "°C") != 0 || !snap.number(ch.key, raw)) continue;
+        if (!hottest_ch || raw > hottest) {
+            hottest = raw;
+            hottest_ch = &ch;
+        }
+    }
+
+    Element reading = hottest_ch ? text(format_scaled(hottest, hottest_ch->divisor, hottest_ch->unit)) | bold
+                                 : text(std::to_string(snap.info->channels.size()) + " channels");
+    return vbox({ text(snap.info->name), reading });
+}
+
+// --- CPU ---
+
+bool CpuSensor::is_compatible(const std::string& path) {
+    // power_supply devices have "online" too, but not "possible".
+    const AttrBackend& backend = attr_backend();
+    return backend.exists(path + "/online") && backend.exists(path + "/possible") && backend.exists("/proc/stat");
+}
+
+// Model name and the highest cpuinfo_max_freq over all cores, read once.
+std::shared_ptr<const DeviceInfo> CpuSensor::describe(const std::string& path) {
+    auto info = std::make_shared<DeviceInfo>();
+    // The first processor's block, where "model name" is, fits in one read.
+    AttrBackend& backend = attr_backend();
+    int fd = backend.open("/proc/cpuinfo");
+    if (fd >= 0) {
+        char buf[4096];
+        ssize_t n = backend.pread(fd, buf, sizeof(buf));
+        backend.close(fd);
+        std::string_view text(buf, n > 0 ? static_cast<size_t>(n) : 0);
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start);
+            if (end == std::string_view::npos) break;
+            std::string_view line = text.substr(start, end - start);
+            start = end + 1;
+            if (line.compare(0, 10, "model name") != 0) continue;
+            size_t colon = line.find(':');
+            size_t first = colon == std::string_view::npos ? colon : line.find_first_not_of(' ', colon + 1);
+            if (first != std::string_view::npos) info->name = std::string(line.substr(first));
+            break;
+        }
+    }
+    if (info->name.empty()) info->name = "CPU";
+
+    ChannelInfo util;
+    util.key = "util";
+    util.label = "Load";
+    util.unit = "%";
+    util.divisor = 10;
+    util.crit = 1000;
+    util.has_crit = true;
+
+    ChannelInfo freq;
+    freq.key = "freq";
+    freq.label = "Frequency";
+    freq.unit = "GHz";
+    freq.divisor = 1000000;
+    for (const std::string& name : attr_backend().list(path)) {
+        if (name.size() < 4 || name.compare(0, 3, "cpu") != 0 || !std::isdigit(static_cast<unsigned char>(name[3]))) {
+            continue;
+        }
+        int64_t khz = 0;
+        if (parse_i64(read_file(path + "/" + name + "/cpufreq/cpuinfo_max_freq"), khz) && khz > freq.crit) {
+            freq.crit = khz;
+            freq.has_crit = true;
+        }
+    }
+
+    info->channels.push_back(std::move(util));
+    info->channels.push_back(std::move(freq));
+    return info;
+}
+
+// Busy share of the jiffies since the previous read, in permille: the last
+// value if none have passed, -1 before there is a previous read.
+static int64_t busy_permille(uint64_t busy, uint64_t total, const CpuTimes& now, int64_t last) {
+    if (total == 0 || now.total < total || now.busy < busy) return -1;
+    uint64_t elapsed = now.total - total;
+    if (elapsed == 0) return last;
+    return static_cast<int64_t>(std::min<uint64_t>((now.busy - busy) * 1000 / elapsed, 1000));
+}
+
+void CpuSensor::sample(const std::string& path, SampleContext& ctx, Snapshot& snap) {
+    State& state = states_.get(path, ctx, [&](State& s) {
+        if (!s.info) s.info = describe(path);
+        if (!s.stat) s.stat = std::make_unique<ProcStat>();
+        for (Core& core : s.cores) {
+            core.opened = false;
+            core.freq = nullptr;
+        }
+        s.series = ctx.history.series(path, "util");
+    });
+    snap.info = state.info;
+
+    state.all_prev = state.all;
+    if (!state.stat->read(state.all, state.times)) return;
+    snap.set_number("cores", static_cast<int64_t>(state.times.size()));
+
+    int64_t freq_sum = 0, freq_count = 0;
+    for (const CpuTimes& times : state.times) {
+        size_t id = static_cast<size_t>(times.cpu);
+        if (id >= state.cores.size()) state.cores.resize(id + 1);
+        Core& core = state.cores[id];
+        if (core.util_key.empty()) {
+            char key[32];
+            std::snprintf(key, sizeof(key), "cpu%zu.util", id);
+            core.util_key = paths().key(key);
+            std::snprintf(key, sizeof(key), "cpu%zu.freq", id);
+            core.freq_key = paths().key(key);
+        }
+        if (!core.opened) {
+            // Cores without cpufreq (VMs, some ARM boards) just have no freq key.
+            char attr[64];
+            std::snprintf(attr, sizeof(attr), "cpu%zu/cpufreq/scaling_cur_freq", id);
+            core.freq = ctx.io.open(path, attr);
+            core.opened = true;
+        }
+
+        core.util = busy_permille(core.busy, core.total, times, core.util);
+        core.busy = times.busy;
+        core.total = times.total;
+        if (core.util >= 0) snap.set_number(core.util_key, core.util);
+
+        long long khz = 0;
+        if (core.freq && ctx.io.read_int(core.freq, khz)) {
+            snap.set_number(core.freq_key, khz);
+            freq_sum += khz;
+            ++freq_count;
+        }
+    }
+    if (freq_count) snap.set_number("freq", freq_sum / freq_count);
+
+    int64_t util = busy_permille(state.all_prev.busy, state.all_prev.total, state.all, -1);
+    if (util < 0) return;
+    snap.set_number("util", util);
+    if (state.series) state.series->push(util);
+    snap.track("util", state.series);
+}
+
+void CpuSensor::forget(const std::string& path) {
+    states_.forget(path);
+}
+
+namespace {
+// "cpu<N>.util" / "cpu<N>.freq" numbers of a snapshot by core number, -1
+// where a core has none. Parsed from the keys, so it works the same for
+// remote and replayed snapshots whatever their order.
+struct CoreReadings {
+    std::vector<int64_t> util;
+    std::vector<int64_t> freq;
+};
+
+CoreReadings core_readings(const Snapshot& snap) {
+    CoreReadings out;
+    for (const auto& [key, value] : snap.numbers) {
+        if (key.size() < 9 || key.compare(0, 3, "cpu") != 0) continue;
+        size_t id = 0;
+        auto [ptr, ec] = std::from_chars(key.data() + 3, key.data() + key.size(), id);
+        if (ec != std::errc() || *ptr != '.') continue;
+        std::string_view field(ptr + 1, key.data() + key.size() - ptr - 1);
+        std::vector<int64_t>* column = field == "util" ? &out.util : field == "freq" ? &out.freq : nullptr;
+        if (!column) continue;
+        if (id >= column->size()) column->resize(id + 1, -1);
+        (*column)[id] = value;
+    }
+    // Both maps get a cell for every core either of them knows.
+    size_t cores = std::max(out.util.size(), out.freq.size());
+    out.util.resize(cores, -1);
+    out.freq.resize(cores, -1);
+    return out;
+}
+
+// Green through yellow to red.
+Color heat(float ratio) {
+    ratio = std::clamp(ratio, 0.0f, 1.0f);
+    auto red = static_cast<uint8_t>(ratio < 0.5f ? 80 + 350 * ratio : 255);
+    auto green = static_cast<uint8_t>(ratio < 0.5f ? 200 : 400 * (1.0f - ratio));
+    return Color::RGB(red, green, 40);
+}
+
+// One two-column cell per core, up to 32 to a row, each row labelled with
+// its first core number. Missing readings are drawn as dots.
+Element heatmap(const std::vector<int64_t>& values, int64_t full) {
+    const size_t count = values.size();
+    const size_t columns = count <= 16 ? count : count <= 64 ? 16 : 32;
+    const int label_width = static_cast<int>(std::to_string(count ? count - 1 : 0).size());
+
+    Elements rows;
+    for (size_t start = 0; start < count; start += columns) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "%*zu ", label_width, start);
+        Elements cells = {text(label) | dim};
+        for (size_t i = start; i < std::min(count, start + columns); ++i) {
+            if (values[i] < 0 || full <= 0) {
+                cells.push_back(text("··") | dim);
+            } else {
+                cells.push_back(text("  ") | bgcolor(heat(static_cast<float>(values[i]) / full)));
+            }
+        }
+        rows.push_back(hbox(std::move(cells)));
+    }
+    return vbox(std::move(rows));
+}
+
+Element heat_legend(const std::string& low, const std::string& high) {
+    Elements cells = {text(low + " ") | dim};
+    for (int i = 0; i <= 8; ++i) cells.push_back(text(" ") | bgcolor(heat(i / 8.0f)));
+    cells.push_back(text(" " + high) | dim);
+    return hbox(std::move(cells));
+}
+}
+
+Element CpuSensor::render(const Snapshot& snap) {
+    int64_t cores = 0;
+    if (!snap.number("cores", cores)) return text("Error reading /proc/stat");
+    CoreReadings readings = core_readings(snap);
+
+    int64_t util = -1, freq = 0;
+    snap.number("util", util);
+    bool have_freq = snap.number("freq", freq);
+
+    Elements lines;
+    if (snap.info) lines.push_back(text(snap.info->name) | bold);
+    lines.push_back(hbox({
+        text("Online: " + std::to_string(cores) + " cores   "),
+        text("Load: "),
+        util < 0 ? text("measuring...") | color(Color::GrayLight)
+                 : text(format_scaled(util, 10, "%")) | bold | color(heat(util / 1000.0f)),
+        text(have_freq ? "   Avg freq: " + format_scaled(freq, 1000000, "GHz") : "")
+    }));
+    if (const Series* series = snap.series("util")) {
+        lines.push_back(history_graph(series, false) | color(Color::Cyan) | size(HEIGHT, EQUAL, 5));
+    }
+    lines.push_back(separator());
+
+    // Frequencies are scaled to the fastest core's maximum, or to the
+    // fastest current one when cpufreq doesn't report a maximum.
+    int64_t full_freq = 0;
+    if (snap.info && snap.info->channels.size() > 1 && snap.info->channels[1].has_crit) {
+        full_freq = snap.info->channels[1].crit;
+    } else {
+        for (int64_t khz : readings.freq) full_freq = std::max(full_freq, khz);
+    }
+
+    Element load_map = vbox({text("Load per core") | bold, heatmap(readings.util, 1000), heat_legend("0%", "100%")});
+    if (have_freq) {
+        Element freq_map = vbox({
+            text("Frequency per core") | bold,
+            heatmap(readings.freq, full_freq),
+            heat_legend("0", format_scaled(full_freq, 1000000, "GHz"))
+        });
+        lines.push_back(hflow({load_map, text("    "), freq_map}));
+    } else {
+        lines.push_back(load_map);
+    }
+
+    // The busiest few, which a 256-cell map doesn't make easy to read off.
+    std::vector<size_t> order;
+    for (size_t i = 0; i < readings.util.size(); ++i) {
+        if (readings.util[i] >= 0) order.push_back(i);
+    }
+    size_t top = std::min<size_t>(order.size(), 5);
+    std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                      [&](size_t a, size_t b) { return readings.util[a] > readings.util[b]; });
+    if (top) {
+        std::string busiest = "Busiest:";
+        for (size_t i = 0; i < top; ++i) {
+            busiest += "  cpu" + std::to_string(order[i]) + " " + format_scaled(readings.util[order[i]], 10, "%");
+        }
+        lines.push_back(separator());
+        lines.push_back(text(busiest) | color(Color::GrayLight));
+    }
+    return vbox(lines);
+}
+
+Element CpuSensor::summary(const Snapshot& snap) {
+    int64_t cores = 0, util = -1, freq = 0;
+    if (!snap.number("cores", cores)) return text("n/a") | color(Color::GrayLight);
+    snap.number("util", util);
+    std::string detail = std::to_string(cores) + " cores";
+    if (snap.number("freq", freq)) detail += " · " + format_scaled(freq, 1000000, "GHz");
+    return vbox({
+        util < 0 ? text("measuring...") | color(Color::GrayLight)
+                 : text(format_scaled(util, 10, "%")) | bold | color(heat(util / 1000.0f)),
+        text(detail) | color(Color::GrayLight)
+    });
+}
+
+std::vector<std::unique_ptr<Sensor>> make_default_drivers() {
+    std::vector<std::unique_ptr<Sensor>> drivers;
+    drivers.push_back(std::make_unique<ThermalSensor>());
+    drivers.push_back(std::make_unique<NetworkSensor>());
+    drivers.push_back(std::make_unique<PowerSensor>());
+    drivers.push_back(std::make_unique<RaplSensor>());  // zones have "name" too, like hwmon
+    drivers.push_back(std::make_unique<HwmonSensor>());
+    drivers.push_back(std::make_unique<CpuSensor>());
+    return drivers;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <ftxui/dom/elements.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpustat.hpp"
+#include "driver.hpp"
+#include "history.hpp"
+#include "paths.hpp"
+#include "rapl.hpp"
+#include "rates.hpp"
+#include "schema.hpp"
+#include "sysfs.hpp"
+
+// Attribute names of the schema-declared drivers.
+namespace attr {
+inline constexpr char kTemp[] = "temp";
+inline constexpr char kOperstate[] = "operstate";
+inline constexpr char kAddress[] = "address";
+inline constexpr char kRxBytes[] = "statistics/rx_bytes";
+inline constexpr char kTxBytes[] = "statistics/tx_bytes";
+inline constexpr char kRxPackets[] = "statistics/rx_packets";
+inline constexpr char kTxPackets[] = "statistics/tx_packets";
+inline constexpr char kRxDropped[] = "statistics/rx_dropped";
+inline constexpr char kRxErrors[] = "statistics/rx_errors";
+inline constexpr char kCapacity[] = "capacity";
+inline constexpr char kStatus[] = "status";
+inline constexpr char kPowerNow[] = "power_now";
+inline constexpr char kCurrentNow[] = "current_now";
+inline constexpr char kVoltageNow[] = "voltage_now";
+inline constexpr char kEnergyNow[] = "energy_now";
+}  // namespace attr
+
+namespace thermal {
+using Temp = schema::Number<attr::kTemp, schema::Millidegrees, schema::kHistory>;
+using Fields = Schema<Temp>;
+}  // namespace thermal
+
+class ThermalSensor : public SchemaSensor<thermal::Fields> {
+public:
+    const char* name() const override { return "thermal"; }
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+
+protected:
+    std::shared_ptr<const DeviceInfo> describe(const std::string& path) override;
+};
+
+namespace net {
+using Operstate = schema::Text<attr::kOperstate>;
+using Address = schema::Text<attr::kAddress>;
+// Byte rates get history so the renderer can graph load over time.
+using RxBytes = schema::Counter<attr::kRxBytes, schema::kHistory>;
+using TxBytes = schema::Counter<attr::kTxBytes, schema::kHistory>;
+using RxPackets = schema::Counter<attr::kRxPackets>;
+using TxPackets = schema::Counter<attr::kTxPackets>;
+using RxDropped = schema::Counter<attr::kRxDropped>;
+using RxErrors = schema::Counter<attr::kRxErrors>;
+using Fields = Schema<Operstate, Address, RxBytes, TxBytes, RxPackets, TxPackets, RxDropped, RxErrors>;
+}  // namespace net
+
+class NetworkSensor : public SchemaSensor<net::Fields> {
+public:
+    const char* name() const override { return "net"; }
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+};
+
+namespace power {
+using Capacity = schema::Number<attr::kCapacity, schema::Percent>;
+using Status = schema::Text<attr::kStatus>;
+using PowerNow = schema::Number<attr::kPowerNow, schema::Microwatts>;
+using CurrentNow = schema::Number<attr::kCurrentNow, schema::Microamps>;
+using VoltageNow = schema::Number<attr::kVoltageNow, schema::Microvolts>;
+using EnergyNow = schema::Number<attr::kEnergyNow, schema::MicrowattHours>;  // charge left
+using Energy = schema::Energy<PowerNow, CurrentNow, VoltageNow>;
+using Fields = Schema<Capacity, Status, PowerNow, CurrentNow, VoltageNow, EnergyNow, Energy>;
+}  // namespace power
+
+class PowerSensor : public SchemaSensor<power::Fields> {
+public:
+    const char* name() const override { return "power"; }
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+};
+
+// RAPL energy zones under /sys/class/powercap (intel-rapl:0 is a package,
+// intel-rapl:0:0 a domain of it). Counters are polled at RaplPoller::kRateHz
+// so the peak catches bursts between samples. Snapshots carry "energy" (µJ
+// this session), "power" (µW since the previous sample), "power_peak" and
+// "power_avg".
+class RaplSensor : public Sensor {
+public:
+    const char* name() const override { return "rapl"; }
+    bool is_compatible(const std::string& path) override;
+    void sample(const std::string& path, SampleContext& ctx, Snapshot& snap) override;
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+    void forget(const std::string& path) override;
+
+private:
+    struct State {
+        const SysfsReader* io = nullptr;
+        std::shared_ptr<const DeviceInfo> info;
+        RaplPoller::Zone* zone = nullptr;  // null if energy_uj isn't readable
+        Series* series = nullptr;
+    };
+
+    RaplPoller poller_;
+    DeviceStates<State> states_;
+};
+
+// Generic driver for /sys/class/hwmon: temperatures, fans, voltages and power.
+// Channels are enumerated once per device into a flat index, after which each
+// tick just walks its arrays of attribute handles.
+class HwmonSensor : public Sensor {
+public:
+    const char* name() const override { return "hwmon"; }
+    bool is_compatible(const std::string& path) override;
+    void sample(const std::string& path, SampleContext& ctx, Snapshot& snap) override;
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+    void forget(const std::string& path) override;
+
+private:
+    // Struct-of-arrays, one slot per channel, aligned with info->channels.
+    struct Index {
+        const SysfsReader* io = nullptr;  // reader the handles belong to
+        std::shared_ptr<const DeviceInfo> info;
+        std::vector<SysfsReader::Handle> inputs;
+        std::vector<std::string_view> keys;  // interned channel keys
+        std::vector<Series*> series;
+    };
+
+    Index build_index(const std::string& path, SampleContext& ctx);
+
+    DeviceStates<Index> index_;
+};
+
+// The whole CPU as one device (/sys/devices/system/cpu): per-core load from
+// /proc/stat and current frequency from cpufreq, drawn as heatmaps. A tick
+// is one pread() of /proc/stat plus one scaling_cur_freq read per core,
+// which the reader batches into a single io_uring submission.
+class CpuSensor : public Sensor {
+public:
+    const char* name() const override { return "cpu"; }
+    bool is_compatible(const std::string& path) override;
+    void sample(const std::string& path, SampleContext& ctx, Snapshot& snap) override;
+    ftxui::Element render(const Snapshot& snap) override;
+    ftxui::Element summary(const Snapshot& snap) override;
+    void forget(const std::string& path) override;
+
+private:
+    // Indexed by core number; grows as cores come online.
+    struct Core {
+        bool opened = false;  // freq resolved through the current reader
+        SysfsReader::Handle freq = nullptr;
+        std::string_view util_key;  // interned "cpu<N>.util"
+        std::string_view freq_key;  // interned "cpu<N>.freq"
+        uint64_t busy = 0;
+        uint64_t total = 0;
+        int64_t util = -1;  // permille, -1 until two reads
+    };
+    struct State {
+        const SysfsReader* io = nullptr;
+        std::shared_ptr<const DeviceInfo> info;
+        std::unique_ptr<ProcStat> stat;
+        CpuTimes all_prev;
+        CpuTimes all;
+        std::vector<CpuTimes> times;  // last parse, reused
+        std::vector<Core> cores;
+        Series* series = nullptr;  // aggregate utilization
+    };
+
+    static std::shared_ptr<const DeviceInfo> describe(const std::string& path);
+
+    DeviceStates<State> states_;
+};
+
+// Every built-in driver, in matching priority order.
+std::vector<std::unique_ptr<Sensor>> make_default_drivers();
@@ -0,0 +1,157 @@
+#include "sockets.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool unix_path(const std::string& address, std::string& path) {
+    if (address.rfind("unix:", 0) == 0) {
+        path = address.substr(5);
+        return true;
+    }
+    if (address.find('/') != std::string::npos) {
+        path = address;
+        return true;
+    }
+    return false;
+}
+
+static bool unix_address(const std::string& path, sockaddr_un& addr, std::string& error) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static addrinfo* resolve(const std::string& address, bool passive, std::string& error) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        error = "expected host:port, got " + address;
+        return nullptr;
+    }
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (passive) hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* result = nullptr;
+    int rc = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+    if (rc != 0) {
+        error = address + ": " + gai_strerror(rc);
+        return nullptr;
+    }
+    return result;
+}
+
+int listen_socket(const std::string& address, std::string& error) {
+    std::string path;
+    if (unix_path(address, path)) {
+        sockaddr_un addr;
+        if (!unix_address(path, addr, error)) return -1;
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return -1;
+        }
+        ::unlink(path.c_str());  // a stale socket from a previous run
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+            error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo* result = resolve(address, true, error);
+    if (!result) return -1;
+    int fd = -1;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && ::listen(fd, 16) == 0) break;
+        error = address + ": " + std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+// A connect that returned, or (non-blocking) one under way.
+static bool connect_started(int fd, const sockaddr* addr, socklen_t len, bool nonblocking) {
+    if (::connect(fd, addr, len) == 0) return true;
+    return nonblocking && (errno == EINPROGRESS || errno == EAGAIN);
+}
+
+static int connect_to(const std::string& address, bool nonblocking, std::string& error) {
+    const int type = SOCK_STREAM | SOCK_CLOEXEC | (nonblocking ? SOCK_NONBLOCK : 0);
+    std::string path;
+    if (unix_path(address, path)) {
+        sockaddr_un addr;
+        if (!unix_address(path, addr, error)) return -1;
+        int fd = ::socket(AF_UNIX, type, 0);
+        if (fd < 0 || !connect_started(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr), nonblocking)) {
+            error = path + ": " + std::strerror(errno);
+            if (fd >= 0) ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo* result = resolve(address, false, error);
+    if (!result) return -1;
+    int fd = -1;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | (type & ~SOCK_STREAM), ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect_started(fd, ai->ai_addr, ai->ai_addrlen, nonblocking)) {
+            // Frames are small and latency matters more than packet count.
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            break;
+        }
+        error = address + ": " + std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+int connect_socket(const std::string& address, std::string& error) {
+    return connect_to(address, false, error);
+}
+
+int start_connect(const std::string& address, std::string& error) {
+    return connect_to(address, true, error);
+}
+
+bool finish_connect(int fd, std::string& error) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+    if (err == 0) return true;
+    error = std::strerror(err);
+    return false;
+}
+
+bool set_nonblocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
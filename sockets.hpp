@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+// Addresses are "host:port", ":port" (any interface, when listening), or a
+// Unix socket path containing a '/', optionally prefixed "unix:".
+// Both return a connected/listening fd, or -1 with `error` filled in.
+int listen_socket(const std::string& address, std::string& error);
+int connect_socket(const std::string& address, std::string& error);
+
+// Non-blocking connect_socket(): the fd is non-blocking and its connect may
+// still be under way, which is done once the fd polls writable;
+// finish_connect() then tells whether it succeeded. Name resolution still
+// blocks.
+int start_connect(const std::string& address, std::string& error);
+bool finish_connect(int fd, std::string& error);
+
+bool set_nonblocking(int fd);
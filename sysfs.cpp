@@ -0,0 +1,267 @@
+#include "sysfs.hpp"
+
+#include "rates.hpp"
+#include "units.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// Each per-path histogram is a few KB; a tree with tens of thousands of
+// attributes (a big rack, a synthetic one) records the rest together.
+static constexpr size_t kMaxPathHistograms = 4096;
+
+std::string read_file(const std::string& path) {
+    static LatencyHistogram* latency = profiler().histogram("read_file");
+    ScopedTimer timer(latency);
+    AttrBackend& backend = attr_backend();
+    int fd = backend.open(path);
+    if (fd < 0) return "";
+    char buf[4096];
+    ssize_t n = backend.pread(fd, buf, sizeof(buf));
+    backend.close(fd);
+    if (n <= 0) return "";
+    size_t len = 0;
+    while (len < static_cast<size_t>(n) && buf[len] != '\n') ++len;
+    return std::string(buf, len);
+}
+
+SysfsReader::SysfsReader()
+    : backend_(attr_backend()),
+      batching_(uring_.ok() && backend_.kernel_fds()),
+      batch_latency_(profiler().histogram("sysfs:batch")) {}
+
+SysfsReader::~SysfsReader() {
+    clear();
+}
+
+SysfsReader::Attr* SysfsReader::lookup(const std::string& device, std::string_view attr) {
+    auto dev = devices_.find(device);
+    if (dev == devices_.end()) dev = devices_.emplace(device, AttrMap{}).first;
+    AttrMap& attrs = dev->second;
+
+    auto it = attrs.find(attr);
+    if (it != attrs.end()) return it->second.get();
+
+    auto entry = std::make_unique<Attr>();
+    entry->path.reserve(device.size() + 1 + attr.size());
+    entry->path.append(device).append("/").append(attr);
+    entry->fd = backend_.open(entry->path);
+    if (entry->fd < 0) return nullptr;
+    entry->latency = profiler().histogram(entry->path, kMaxPathHistograms, "sysfs:other");
+    return attrs.emplace(std::string(attr), std::move(entry)).first->second.get();
+}
+
+SysfsReader::Handle SysfsReader::open(const std::string& device, std::string_view attr) {
+    return lookup(device, attr);
+}
+
+static int finish_line(char* buf, size_t n) {
+    size_t len = 0;
+    while (len < n && buf[len] != '\n') ++len;
+    buf[len] = '\0';
+    return static_cast<int>(len);
+}
+
+void SysfsReader::begin_pass() {
+    ++pass_;
+    if (adaptive_) {
+        // Only what's due now; the rest is served from the last value.
+        // Copied rather than swapped so every slot keeps its own capacity.
+        std::vector<Attr*>& due = wheel_[pass_ % kWheelSlots];
+        batch_.assign(due.begin(), due.end());
+        due.clear();
+    } else {
+        batch_.swap(touched_);
+        touched_.clear();
+    }
+    if (!batching_ || batch_.empty()) return;
+
+    ScopedTimer timer(batch_latency_);
+    std::sort(batch_.begin(), batch_.end(), [](const Attr* a, const Attr* b) { return a->fd < b->fd; });
+    requests_.clear();
+    for (Attr* a : batch_) {
+        if (a->fd >= 0) requests_.push_back({a->fd, a->buf, kPrefetchSize, 0});
+    }
+    if (!uring_.read_all(requests_.data(), requests_.size())) return;
+
+    size_t r = 0;
+    for (Attr* a : batch_) {
+        if (a->fd < 0) continue;
+        a->len = requests_[r++].result;
+        a->filled_pass = pass_;
+    }
+}
+
+int SysfsReader::read(const std::string& device, std::string_view attr, char* buf, size_t cap) {
+    Attr* a = lookup(device, attr);
+    if (!a) return -1;
+    return read(a, buf, cap);
+}
+
+int SysfsReader::read(Handle attr, char* buf, size_t cap) {
+    if (!attr || cap == 0) return -1;
+    Attr& a = *attr;
+
+    if (a.used_pass != pass_) {
+        a.used_pass = pass_;
+        if (!adaptive_) touched_.push_back(&a);
+    }
+
+    if (adaptive_ && a.value_len >= 0 && pass_ < a.due_pass) {
+        size_t n = static_cast<size_t>(a.value_len);
+        if (n > cap - 1) n = cap - 1;
+        std::memcpy(buf, a.value, n);
+        buf[n] = '\0';
+        fresh_ = false;
+        return static_cast<int>(n);
+    }
+
+    // Served from this pass's prefetch when it read cleanly and wasn't
+    // truncated; anything else takes the direct path, which also handles
+    // reopening after ENODEV.
+    int n;
+    if (a.filled_pass == pass_ && a.len >= 0 && static_cast<unsigned>(a.len) < kPrefetchSize) {
+        size_t len = static_cast<size_t>(a.len);
+        if (len > cap - 1) len = cap - 1;
+        std::memcpy(buf, a.buf, len);
+        n = finish_line(buf, len);
+    } else {
+        int64_t start = monotonic_ns();
+        n = read_direct(a, buf, cap);
+        int64_t cost = monotonic_ns() - start;
+        if (a.latency) a.latency->record(cost);
+        a.cost_ns = a.cost_ns ? (a.cost_ns * 3 + cost) / 4 : cost;
+    }
+    fresh_ = true;
+    if (adaptive_) reschedule(a, buf, n);
+    return n;
+}
+
+void SysfsReader::reschedule(Attr& a, const char* value, int len) {
+    // Errors and values too long to cache are simply read again next time.
+    if (len < 0 || static_cast<unsigned>(len) >= kPrefetchSize) {
+        a.value_len = -1;
+        return;
+    }
+
+    bool changed = len != a.value_len || std::memcmp(value, a.value, len) != 0;
+    std::memcpy(a.value, value, len);
+    a.value_len = len;
+
+    unsigned floor = a.cost_ns >= kSlowReadNs ? kSlowInterval : 1;
+    if (changed) {
+        a.interval = floor;
+        a.steady = 0;
+    } else if (++a.steady >= kSteadyReads) {
+        a.interval = std::min(a.interval * 2, kMaxInterval);
+        a.steady = 0;
+    }
+    a.interval = std::max(a.interval, floor);
+
+    a.due_pass = pass_ + a.interval;
+    wheel_[a.due_pass % kWheelSlots].push_back(&a);
+}
+
+int SysfsReader::read_direct(Attr& a, char* buf, size_t cap) {
+    if (a.fd < 0) {
+        a.fd = backend_.open(a.path);
+        if (a.fd < 0) return -1;
+    }
+
+    // A second attempt is only made after reopening a stale fd.
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        ssize_t n = backend_.pread(a.fd, buf, cap - 1);
+        if (n >= 0) return finish_line(buf, static_cast<size_t>(n));
+
+        int err = errno;
+        if (err == EINTR) continue;
+        // Anything else (EIO, EINVAL on a link that's down, ...) is a
+        // transient attribute error; the fd itself is still good.
+        if (err != ENODEV && err != ENOENT && err != ESTALE) return -1;
+
+        // The device went away, possibly replaced by a new one with the same
+        // name: drop the stale fd and try a fresh open once.
+        backend_.close(a.fd);
+        a.fd = backend_.open(a.path);
+        if (a.fd < 0) return -1;
+    }
+    return -1;
+}
+
+std::string SysfsReader::read_string(const std::string& device, std::string_view attr) {
+    char buf[4096];
+    int n = read(device, attr, buf, sizeof(buf));
+    if (n < 0) return "";
+    return std::string(buf, n);
+}
+
+bool SysfsReader::read_int(const std::string& device, std::string_view attr, long long& out) {
+    return read_int(lookup(device, attr), out);
+}
+
+bool SysfsReader::read_int(Handle attr, long long& out) {
+    char buf[32];
+    int n = read(attr, buf, sizeof(buf));
+    if (n <= 0) return false;
+
+    int64_t value = 0;
+    if (!parse_i64(std::string_view(buf, n), value)) return false;
+    out = value;
+    return true;
+}
+
+bool SysfsReader::read_u64(const std::string& device, std::string_view attr, unsigned long long& out) {
+    return read_u64(lookup(device, attr), out);
+}
+
+bool SysfsReader::read_u64(Handle attr, unsigned long long& out) {
+    char buf[32];
+    int n = read(attr, buf, sizeof(buf));
+    if (n <= 0) return false;
+
+    uint64_t value = 0;
+    if (!parse_u64(std::string_view(buf, n), value)) return false;
+    out = value;
+    return true;
+}
+
+void SysfsReader::forget(const std::string& device) {
+    auto dev = devices_.find(device);
+    if (dev == devices_.end()) return;
+
+    auto owned = [&](const Attr* a) {
+        for (const auto& attr : dev->second) {
+            if (attr.second.get() == a) return true;
+        }
+        return false;
+    };
+    touched_.erase(std::remove_if(touched_.begin(), touched_.end(), owned), touched_.end());
+    batch_.erase(std::remove_if(batch_.begin(), batch_.end(), owned), batch_.end());
+    for (auto& slot : wheel_) slot.erase(std::remove_if(slot.begin(), slot.end(), owned), slot.end());
+
+    for (const auto& attr : dev->second) {
+        if (attr.second->fd >= 0) backend_.close(attr.second->fd);
+    }
+    devices_.erase(dev);
+}
+
+void SysfsReader::clear() {
+    touched_.clear();
+    batch_.clear();
+    for (auto& slot : wheel_) slot.clear();
+    for (const auto& dev : devices_) {
+        for (const auto& attr : dev.second) {
+            if (attr.second->fd >= 0) backend_.close(attr.second->fd);
+        }
+    }
+    devices_.clear();
+}
+
+size_t SysfsReader::open_count() const {
+    size_t count = 0;
+    for (const auto& dev : devices_) {
+        for (const auto& attr : dev.second) count += attr.second->fd >= 0;
+    }
+    return count;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "backend.hpp"
+#include "profile.hpp"
+#include "uring.hpp"
+
+// One-shot read of the first line of a file. Fine for rare lookups; the
+// sampler hot path goes through SysfsReader instead.
+std::string read_file(const std::string& path);
+
+// Keeps sysfs attribute files open per (device, attribute) and re-reads them
+// with pread() at offset 0, so a steady-state poll costs a single syscall.
+//
+// Callers that sample in passes (one per tick) can call begin_pass() first:
+// every attribute read during the previous pass is then fetched up front in
+// one io_uring submission, sorted by fd, and reads during the pass are served
+// from that buffer. Without io_uring, begin_pass() only advances the pass.
+// Direct reads are timed per attribute path (the first few thousand paths;
+// the rest share "sysfs:other") and each batch as a whole in profiler()
+// ("sysfs:batch"). Files are opened through the attribute backend installed
+// when the reader is made; batching needs one whose handles are kernel fds.
+//
+// With set_adaptive(true) each attribute also gets its own poll interval, in
+// passes: it starts at one, doubles after a few unchanged reads up to
+// kMaxInterval, drops back to one on change, and never goes below
+// kSlowInterval for reads that cost more than kSlowReadNs (ACPI thermal
+// zones). Attributes wait in a timer wheel for the pass they're due in; in
+// between, reads return the last value without a syscall. Only the due
+// slot is prefetched.
+// Not thread-safe: each sampler thread owns its own reader.
+class SysfsReader {
+    struct Attr;
+
+public:
+    // Stable reference to one open attribute, for drivers that resolve their
+    // attributes once and then read them every tick without any lookup.
+    // Valid until forget() or clear() drops its device.
+    using Handle = Attr*;
+
+    SysfsReader();
+    ~SysfsReader();
+
+    SysfsReader(const SysfsReader&) = delete;
+    SysfsReader& operator=(const SysfsReader&) = delete;
+
+    void begin_pass();
+    bool batching() const { return batching_; }
+
+    // Set before the first read; adaptive polling needs one begin_pass() per tick.
+    void set_adaptive(bool on) { adaptive_ = on; }
+
+    // Whether the last successful read() came from the kernel rather than
+    // the adaptive cache. Counter-based rates should only advance on fresh reads.
+    bool fresh() const { return fresh_; }
+
+    // Reads the first line of <device>/<attr> into buf (newline stripped,
+    // NUL-terminated). Returns its length, or -1 if it can't be read.
+    int read(const std::string& device, std::string_view attr, char* buf, size_t cap);
+
+    std::string read_string(const std::string& device, std::string_view attr);
+    bool read_int(const std::string& device, std::string_view attr, long long& out);
+    bool read_u64(const std::string& device, std::string_view attr, unsigned long long& out);
+
+    // Returns nullptr if the attribute can't be opened.
+    Handle open(const std::string& device, std::string_view attr);
+    int read(Handle attr, char* buf, size_t cap);
+    bool read_int(Handle attr, long long& out);
+    bool read_u64(Handle attr, unsigned long long& out);
+
+    // Closes every fd held for a device, e.g. after it was unplugged.
+    void forget(const std::string& device);
+    void clear();
+
+    size_t open_count() const;
+
+private:
+    static constexpr unsigned kPrefetchSize = 256;
+
+    static constexpr size_t kWheelSlots = 64;
+    static constexpr unsigned kMaxInterval = 32;     // passes; must stay below kWheelSlots
+    static constexpr unsigned kSteadyReads = 3;      // unchanged reads before backing off
+    static constexpr unsigned kSlowInterval = 4;
+    static constexpr int64_t kSlowReadNs = 1000000;
+
+    struct Attr {
+        std::string path;
+        int fd = -1;
+        uint64_t used_pass = 0;    // last pass that read it
+        uint64_t filled_pass = 0;  // pass whose prefetch filled buf
+        int len = -1;              // prefetch result: bytes, or -errno
+        LatencyHistogram* latency = nullptr;  // direct pread() times, keyed by path
+        char buf[kPrefetchSize];
+
+        // Adaptive polling state.
+        int64_t cost_ns = 0;    // smoothed direct read time
+        uint64_t due_pass = 0;  // first pass that reads it again
+        unsigned interval = 1;
+        unsigned steady = 0;    // unchanged reads at the current interval
+        int value_len = -1;     // last value, or -1 if none cached
+        char value[kPrefetchSize];
+    };
+    // unique_ptr keeps Attr addresses stable for the pass lists below.
+    using AttrMap = std::map<std::string, std::unique_ptr<Attr>, std::less<>>;
+
+    Attr* lookup(const std::string& device, std::string_view attr);
+    int read_direct(Attr& a, char* buf, size_t cap);
+    void reschedule(Attr& a, const char* value, int len);
+
+    std::map<std::string, AttrMap, std::less<>> devices_;
+
+    AttrBackend& backend_;
+    UringReader uring_;
+    bool batching_;
+    uint64_t pass_ = 1;
+    std::vector<Attr*> touched_;  // attributes read during the current pass
+    std::vector<Attr*> batch_;
+    std::vector<UringReader::Request> requests_;
+    LatencyHistogram* batch_latency_;
+
+    bool adaptive_ = false;
+    bool fresh_ = true;
+    std::array<std::vector<Attr*>, kWheelSlots> wheel_;  // indexed by due_pass
+};
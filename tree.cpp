@@ -0,0 +1,308 @@
+#include "tree.hpp"
+
+#include "filter.hpp"
+#include "rates.hpp"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ftxui;
+
+std::string_view SysfsTree::Row::name() const {
+    if (depth == 0) return path;
+    size_t slash = path.rfind('/');
+    return std::string_view(path).substr(slash + 1);
+}
+
+SysfsTree::SysfsTree(std::vector<std::string> roots, size_t cached_dirs) : capacity_(std::max<size_t>(cached_dirs, 1)) {
+    for (auto& root : roots) {
+        Row row;
+        row.path = std::move(root);
+        row.kind = Kind::Dir;
+        row.resolved = true;
+        rows_.push_back(std::move(row));
+    }
+}
+
+static SysfsTree::Kind kind_of(unsigned char d_type, const std::string& path) {
+    switch (d_type) {
+    case DT_DIR: return SysfsTree::Kind::Dir;
+    case DT_REG: return SysfsTree::Kind::File;
+    case DT_LNK: return SysfsTree::Kind::Link;
+    case DT_UNKNOWN: break;
+    default: return SysfsTree::Kind::Other;
+    }
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) return SysfsTree::Kind::Other;
+    if (S_ISDIR(st.st_mode)) return SysfsTree::Kind::Dir;
+    if (S_ISREG(st.st_mode)) return SysfsTree::Kind::File;
+    if (S_ISLNK(st.st_mode)) return SysfsTree::Kind::Link;
+    return SysfsTree::Kind::Other;
+}
+
+const std::vector<SysfsTree::Entry>& SysfsTree::list(const std::string& path) {
+    int64_t now = monotonic_ns();
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        if (now - it->second->listed_ns < kListingTtlNs) return it->second->entries;
+    } else {
+        lru_.push_front(Listing{path, 0, {}});
+        index_.emplace(lru_.front().path, lru_.begin());
+        if (lru_.size() > capacity_) {
+            index_.erase(lru_.back().path);
+            lru_.pop_back();
+        }
+    }
+
+    Listing& listing = lru_.front();
+    listing.listed_ns = now;
+    listing.entries.clear();
+    if (DIR* dir = ::opendir(path.c_str())) {
+        while (dirent* d = ::readdir(dir)) {
+            if (d->d_name[0] == '.' && (d->d_name[1] == '\0' || (d->d_name[1] == '.' && d->d_name[2] == '\0'))) {
+                continue;
+            }
+            std::string name = d->d_name;
+            Kind kind = kind_of(d->d_type, path + "/" + name);
+            listing.entries.push_back({std::move(name), kind});
+        }
+        ::closedir(dir);
+    }
+    std::sort(listing.entries.begin(), listing.entries.end(),
+              [](const Entry& a, const Entry& b) { return a.name < b.name; });
+    return listing.entries;
+}
+
+void SysfsTree::expand(size_t index) {
+    if (index >= rows_.size()) return;
+    resolve(rows_[index]);
+    if (!rows_[index].expandable() || rows_[index].expanded) return;
+
+    const std::string parent_path = rows_[index].path;
+    const uint16_t depth = rows_[index].depth + 1;
+    const auto& entries = list(parent_path);
+
+    std::vector<Row> children;
+    children.reserve(entries.size());
+    for (const auto& entry : entries) {
+        Row row;
+        row.path.reserve(parent_path.size() + 1 + entry.name.size());
+        row.path.append(parent_path).append("/").append(entry.name);
+        row.depth = depth;
+        row.kind = entry.kind;
+        children.push_back(std::move(row));
+    }
+    rows_[index].expanded = true;
+    ++generation_;
+    rows_.insert(rows_.begin() + index + 1, std::make_move_iterator(children.begin()),
+                 std::make_move_iterator(children.end()));
+}
+
+void SysfsTree::collapse(size_t index) {
+    if (index >= rows_.size() || !rows_[index].expanded) return;
+    size_t end = index + 1;
+    while (end < rows_.size() && rows_[end].depth > rows_[index].depth) ++end;
+    rows_.erase(rows_.begin() + index + 1, rows_.begin() + end);
+    rows_[index].expanded = false;
+    ++generation_;
+}
+
+size_t SysfsTree::parent(size_t index) const {
+    if (index >= rows_.size() || rows_[index].depth == 0) return index;
+    size_t i = index;
+    while (i > 0 && rows_[i].depth >= rows_[index].depth) --i;
+    return i;
+}
+
+void SysfsTree::resolve(Row& row) {
+    if (row.resolved) return;
+    row.resolved = true;
+    if (row.kind != Kind::Link) return;
+
+    char buf[4096];
+    ssize_t n = ::readlink(row.path.c_str(), buf, sizeof(buf));
+    if (n > 0) row.target.assign(buf, static_cast<size_t>(n));
+    struct stat st;
+    row.link_dir = ::stat(row.path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// First line of an attribute, with anything unprintable (binary attributes
+// like PCI config space) shown as '.'.
+static std::string read_value(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) return "(unreadable)";
+    char buf[96];
+    ssize_t n = ::pread(fd, buf, sizeof(buf), 0);
+    ::close(fd);
+    if (n < 0) return "(unreadable)";
+
+    std::string value;
+    for (ssize_t i = 0; i < n && buf[i] != '\n'; ++i) {
+        unsigned char c = static_cast<unsigned char>(buf[i]);
+        value.push_back(c >= 0x20 && c < 0x7f ? static_cast<char>(c) : '.');
+    }
+    if (n == static_cast<ssize_t>(sizeof(buf)) && value.size() == sizeof(buf)) value += "...";
+    return value;
+}
+
+void SysfsTree::prepare(size_t first, size_t last, int64_t now_ns) {
+    last = std::min(last, rows_.size());
+    for (size_t i = first; i < last; ++i) {
+        Row& row = rows_[i];
+        resolve(row);
+        if (row.kind == Kind::File && (row.value_ns == 0 || now_ns - row.value_ns >= kValueRefreshNs)) {
+            row.value = read_value(row.path);
+            row.value_ns = now_ns;
+        }
+    }
+}
+
+namespace {
+
+class TreeBase : public ComponentBase {
+public:
+    TreeBase(SysfsTree* tree, std::string* selected, const std::string* filter)
+        : tree_(tree), selected_(selected), filter_(filter) {}
+
+    Element Render() override {
+        update_view();
+        if (tree_->size() == 0) return text("  (Nothing to browse)") | yflex | reflect(box_);
+        const int count = static_cast<int>(rows());
+        if (count == 0) return text("  (No matches)") | dim | yflex | reflect(box_);
+        cursor_ = std::clamp(cursor_, 0, count - 1);
+
+        // Same windowing as DeviceMenu: the height comes from the last frame.
+        int rows = box_.y_max >= box_.y_min && box_.y_max > 0 ? box_.y_max - box_.y_min + 1 : 64;
+        page_ = std::max(1, rows);
+        if (cursor_ < top_) top_ = cursor_;
+        if (cursor_ >= top_ + page_) top_ = cursor_ - page_ + 1;
+        top_ = std::clamp(top_, 0, std::max(0, count - page_));
+        int end = std::min(count, top_ + page_);
+        if (query_.empty()) {
+            tree_->prepare(top_, end, monotonic_ns());
+        } else {
+            int64_t now = monotonic_ns();
+            for (int i = top_; i < end; ++i) tree_->prepare(index_at(i), index_at(i) + 1, now);
+        }
+
+        Elements lines;
+        for (int i = top_; i < end; ++i) {
+            const SysfsTree::Row& row = tree_->row(index_at(i));
+            const char* marker = row.expanded ? "▾ " : row.expandable() ? "▸ " : "  ";
+            Element name = text(std::string(row.depth * 2, ' ') + marker + std::string(row.name()));
+            if (row.expandable()) name = name | bold;
+            if (i == cursor_) name = name | inverted;
+
+            Element detail = emptyElement();
+            if (row.kind == SysfsTree::Kind::Link) {
+                detail = text(" -> " + row.target) | dim;
+            } else if (row.kind == SysfsTree::Kind::File) {
+                detail = text("  " + row.value) | color(Color::Cyan);
+            }
+            lines.push_back(hbox({name, detail}));
+        }
+        *selected_ = tree_->row(index_at(cursor_)).path;
+        return vbox(std::move(lines)) | yflex | reflect(box_);
+    }
+
+    bool OnEvent(Event event) override {
+        update_view();
+        const int count = static_cast<int>(rows());
+        if (count == 0) return false;
+        cursor_ = std::clamp(cursor_, 0, count - 1);
+        size_t at = index_at(cursor_);
+        bool follow = false;  // put the cursor back on tree row `at`
+        if (event == Event::ArrowUp) {
+            --cursor_;
+        } else if (event == Event::ArrowDown) {
+            ++cursor_;
+        } else if (event == Event::PageUp) {
+            cursor_ -= page_;
+        } else if (event == Event::PageDown) {
+            cursor_ += page_;
+        } else if (event == Event::Home) {
+            cursor_ = 0;
+        } else if (event == Event::End) {
+            cursor_ = count - 1;
+        } else if (event == Event::ArrowRight || event == Event::Return) {
+            if (tree_->row(at).expanded) {
+                ++cursor_;
+            } else {
+                tree_->expand(at);
+                follow = true;
+            }
+        } else if (event == Event::ArrowLeft) {
+            if (tree_->row(at).expanded) {
+                tree_->collapse(at);
+            } else {
+                at = tree_->parent(at);
+            }
+            follow = true;
+        } else {
+            return false;
+        }
+        if (follow) {
+            // Onto `at`, or the next row if the filter hid it (a collapsed
+            // directory kept only for its matching children).
+            update_view();
+            cursor_ = static_cast<int>(row_of(at));
+        }
+        cursor_ = std::clamp(cursor_, 0, std::max(0, static_cast<int>(rows()) - 1));
+        return true;
+    }
+
+    bool Focusable() const override { return true; }
+
+private:
+    size_t rows() const { return query_.empty() ? tree_->size() : shown_.size(); }
+    size_t index_at(int row) const { return query_.empty() ? row : shown_[row]; }
+    size_t row_of(size_t index) const {
+        if (query_.empty()) return index;
+        return std::lower_bound(shown_.begin(), shown_.end(), index) - shown_.begin();
+    }
+
+    // Recomputes the shown rows when the filter or the tree changed. Only
+    // expanded rows exist, so this is a scan of what has been opened, not
+    // of sysfs. Walking backwards, a row shallower than the last one kept
+    // is its parent and is kept too.
+    void update_view() {
+        if (*filter_ == query_.text() && generation_ == tree_->generation()) return;
+        size_t cursor_index = rows() ? index_at(std::clamp(cursor_, 0, static_cast<int>(rows()) - 1)) : 0;
+        query_ = NameQuery(*filter_);
+        generation_ = tree_->generation();
+        shown_.clear();
+        if (!query_.empty()) {
+            int keep_above = -1;  // depth below which the next ancestor is kept
+            for (size_t i = tree_->size(); i-- > 0;) {
+                const SysfsTree::Row& row = tree_->row(i);
+                if (query_.matches(row.name()) || row.depth < keep_above) {
+                    shown_.push_back(static_cast<uint32_t>(i));
+                    keep_above = row.depth;
+                }
+            }
+            std::reverse(shown_.begin(), shown_.end());
+        }
+        cursor_ = static_cast<int>(std::min(row_of(cursor_index), rows() ? rows() - 1 : 0));
+    }
+
+    SysfsTree* tree_;
+    std::string* selected_;
+    const std::string* filter_;
+    NameQuery query_;
+    uint64_t generation_ = ~0ull;
+    std::vector<uint32_t> shown_;  // tree rows shown, ascending; when filtering
+    Box box_;
+    int cursor_ = 0;
+    int top_ = 0;
+    int page_ = 1;
+};
+
+}  // namespace
+
+Component TreeExplorer(SysfsTree* tree, std::string* selected, const std::string* filter) {
+    return std::make_shared<TreeBase>(tree, selected, filter);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <ftxui/component/component.hpp>
+
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A browsable view of arbitrary sysfs directories (by default /sys/class,
+// /sys/devices and /sys/bus), for everything the category drivers don't
+// cover. Nothing is walked up front: a directory is listed when it is
+// expanded, symlink targets are resolved and attribute values read only for
+// the rows being drawn. Listings are kept in a bounded LRU cache so
+// collapsing and re-expanding a node doesn't hit the filesystem again.
+class SysfsTree {
+public:
+    enum class Kind : uint8_t { Dir, File, Link, Other };
+
+    struct Row {
+        std::string path;
+        uint16_t depth = 0;
+        Kind kind = Kind::Other;
+        bool expanded = false;
+
+        // Filled in by prepare() once the row becomes visible.
+        bool resolved = false;
+        bool link_dir = false;  // a Link whose target is a directory
+        std::string target;     // readlink() of a Link
+        std::string value;      // first line of a File
+        int64_t value_ns = 0;   // when `value` was read
+
+        std::string_view name() const;
+        bool expandable() const { return kind == Kind::Dir || (kind == Kind::Link && link_dir); }
+    };
+
+    static constexpr size_t kCachedDirs = 256;
+
+    explicit SysfsTree(std::vector<std::string> roots = {"/sys/class", "/sys/devices", "/sys/bus"},
+                       size_t cached_dirs = kCachedDirs);
+
+    size_t size() const { return rows_.size(); }
+    const Row& row(size_t index) const { return rows_[index]; }
+
+    // Expanding inserts the directory's entries right after it; collapsing
+    // removes everything below it.
+    void expand(size_t index);
+    void collapse(size_t index);
+    // Index of the row's parent, or the row itself at the top level.
+    size_t parent(size_t index) const;
+
+    // Resolves and reads rows [first, last) for drawing. Values older than
+    // kValueRefreshNs are read again.
+    void prepare(size_t first, size_t last, int64_t now_ns);
+
+    size_t cached_dirs() const { return lru_.size(); }
+    // Bumped whenever rows are inserted or removed.
+    uint64_t generation() const { return generation_; }
+
+private:
+    struct Entry {
+        std::string name;
+        Kind kind;
+    };
+    struct Listing {
+        std::string path;
+        int64_t listed_ns = 0;
+        std::vector<Entry> entries;
+    };
+
+    static constexpr int64_t kValueRefreshNs = 1000000000;
+    static constexpr int64_t kListingTtlNs = 5000000000;
+
+    const std::vector<Entry>& list(const std::string& path);
+    void resolve(Row& row);
+
+    std::vector<Row> rows_;
+    uint64_t generation_ = 0;
+    size_t capacity_;
+    std::list<Listing> lru_;  // most recently used first
+    std::unordered_map<std::string_view, std::list<Listing>::iterator> index_;
+};
+
+// Tree view over a SysfsTree that only draws the visible rows. Up/Down,
+// PageUp/PageDown and Home/End move; Right/Enter expands, Left collapses or
+// jumps to the parent. `selected` receives the selected row's path.
+// A non-empty `filter` (a NameQuery) hides the expanded rows whose names
+// don't match, except the directories leading to ones that do.
+ftxui::Component TreeExplorer(SysfsTree* tree, std::string* selected, const std::string* filter);
@@ -0,0 +1,93 @@
+#include "units.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <mutex>
+#include <set>
+
+static std::string_view trim(std::string_view raw) {
+    while (!raw.empty() && (raw.front() == ' ' || raw.front() == '\t')) raw.remove_prefix(1);
+    while (!raw.empty() && (raw.back() == ' ' || raw.back() == '\t' || raw.back() == '\n')) raw.remove_suffix(1);
+    return raw;
+}
+
+template <typename T>
+static bool parse_whole(std::string_view raw, T& out) {
+    raw = trim(raw);
+    if (raw.empty()) return false;
+    const char* first = raw.data();
+    const char* last = raw.data() + raw.size();
+    if (*first == '+') ++first;
+    auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+bool parse_i64(std::string_view raw, int64_t& out) {
+    return parse_whole(raw, out);
+}
+
+bool parse_u64(std::string_view raw, uint64_t& out) {
+    return parse_whole(raw, out);
+}
+
+bool parse_fixed(std::string_view raw, int64_t scale, int64_t& out) {
+    raw = trim(raw);
+    size_t dot = raw.find('.');
+    if (dot == std::string_view::npos) {
+        int64_t whole = 0;
+        if (!parse_i64(raw, whole)) return false;
+        out = whole * scale;
+        return true;
+    }
+
+    std::string_view int_part = raw.substr(0, dot);
+    std::string_view frac_part = raw.substr(dot + 1);
+    bool negative = !int_part.empty() && int_part.front() == '-';
+
+    int64_t whole = 0;
+    if (!int_part.empty() && int_part != "-" && int_part != "+" && !parse_i64(int_part, whole)) return false;
+
+    int64_t frac = 0;
+    int64_t place = scale;
+    for (char c : frac_part) {
+        if (c < '0' || c > '9') return false;
+        place /= 10;
+        if (place == 0) break;
+        frac += (c - '0') * place;
+    }
+
+    out = whole * scale + (negative ? -frac : frac);
+    return true;
+}
+
+std::string format_scaled(int64_t raw, int64_t divisor, const char* unit) {
+    char buf[32];
+    if (divisor == 1) {
+        std::snprintf(buf, sizeof(buf), "%lld %s", static_cast<long long>(raw), unit);
+    } else {
+        std::snprintf(buf, sizeof(buf), "%.*f %s", divisor >= 1000000 ? 2 : 1,
+                      static_cast<double>(raw) / divisor, unit);
+    }
+    return buf;
+}
+
+std::string format_rate(double per_second, const char* unit) {
+    static const char* const prefixes[] = {"", "k", "M", "G", "T"};
+    int i = 0;
+    while (per_second >= 1000.0 && i < 4) {
+        per_second /= 1000.0;
+        ++i;
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f %s%s/s", per_second, prefixes[i], unit);
+    return buf;
+}
+
+const char* intern_unit(std::string_view unit) {
+    static std::mutex mutex;
+    static std::set<std::string, std::less<>> units;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = units.find(unit);
+    if (it == units.end()) it = units.emplace(unit).first;
+    return it->c_str();
+}
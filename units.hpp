@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Allocation-free parsing of sysfs values straight from a read buffer, and
+// the display-time formatting that goes with it. Samples are kept as
+// integers in the kernel's own fixed-point units (millidegree Celsius,
+// microwatt, millivolt, ...); floats only appear when a value is formatted.
+
+// Decimal integer with optional surrounding blanks/newline. No exceptions;
+// false on empty, malformed or out-of-range input.
+bool parse_i64(std::string_view raw, int64_t& out);
+bool parse_u64(std::string_view raw, uint64_t& out);
+
+// Decimal with an optional fraction into fixed point, e.g. "1.25" with
+// scale 1000 -> 1250. Extra fraction digits are truncated.
+bool parse_fixed(std::string_view raw, int64_t scale, int64_t& out);
+
+// raw / divisor with a unit, e.g. (45250, 1000, "°C") -> "45.2 °C". Uses
+// one decimal, two for divisors of a million or more, none for divisor 1.
+std::string format_scaled(int64_t raw, int64_t divisor, const char* unit);
+
+// SI-prefixed rate, e.g. (1.5e6, "B") -> "1.5 MB/s".
+std::string format_rate(double per_second, const char* unit);
+
+// Stable C string for a unit name that arrived at runtime (decoded from a
+// stream or a recording), since ChannelInfo::unit is never freed.
+const char* intern_unit(std::string_view unit);
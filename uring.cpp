@@ -0,0 +1,136 @@
+#include "uring.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template <typename T>
+static T* at(void* base, unsigned offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+UringReader::UringReader(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = uring_setup(entries, &params);
+    if (fd < 0) return;
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && cq_ring_size_ > sq_ring_size_) sq_ring_size_ = cq_ring_size_;
+
+    sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        ::close(fd);
+        return;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          fd, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            ::munmap(sq_ring_, sq_ring_size_);
+            sq_ring_ = nullptr;
+            ::close(fd);
+            return;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+        ::munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = cq_ring_ = nullptr;
+        ::close(fd);
+        return;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_tail_ = at<unsigned>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = at<unsigned>(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = at<unsigned>(sq_ring_, params.sq_off.array);
+    cq_head_ = at<unsigned>(cq_ring_, params.cq_off.head);
+    cq_tail_ = at<unsigned>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = at<unsigned>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = at<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+
+    entries_ = params.sq_entries;
+    ring_fd_ = fd;
+}
+
+UringReader::~UringReader() {
+    if (ring_fd_ < 0) return;
+    ::munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_ring_size_);
+    ::munmap(sq_ring_, sq_ring_size_);
+    ::close(ring_fd_);
+}
+
+bool UringReader::read_all(Request* reqs, size_t count) {
+    if (ring_fd_ < 0) return false;
+
+    size_t done = 0;
+    while (done < count) {
+        unsigned batch = static_cast<unsigned>(count - done < entries_ ? count - done : entries_);
+
+        unsigned tail = *sq_tail_;
+        unsigned mask = *sq_mask_;
+        for (unsigned i = 0; i < batch; ++i) {
+            Request& req = reqs[done + i];
+            unsigned idx = (tail + i) & mask;
+            io_uring_sqe* sqe = &sqes_[idx];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = req.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(req.buf);
+            sqe->len = req.len;
+            sqe->off = 0;
+            sqe->user_data = done + i;
+            sq_array_[idx] = idx;
+        }
+        __atomic_store_n(sq_tail_, tail + batch, __ATOMIC_RELEASE);
+
+        unsigned submitted = 0;
+        unsigned reaped = 0;
+        while (reaped < batch) {
+            unsigned to_submit = batch - submitted;
+            int ret = uring_enter(ring_fd_, to_submit, 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            submitted += static_cast<unsigned>(ret);
+
+            unsigned head = *cq_head_;
+            unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            while (head != cq_tail) {
+                const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+                reqs[cqe.user_data].result = cqe.res;
+                ++head;
+                ++reaped;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        done += batch;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+// Minimal io_uring wrapper for batches of reads at offset 0. Talks to the
+// kernel directly (no liburing dependency); if io_uring is missing or blocked
+// by seccomp, ok() is false and callers fall back to pread().
+class UringReader {
+public:
+    struct Request {
+        int fd;
+        char* buf;
+        unsigned len;
+        int result;  // bytes read, or -errno
+    };
+
+    explicit UringReader(unsigned entries = 256);
+    ~UringReader();
+
+    UringReader(const UringReader&) = delete;
+    UringReader& operator=(const UringReader&) = delete;
+
+    bool ok() const { return ring_fd_ >= 0; }
+
+    // Issues every request, at most `entries` per submission, and waits for
+    // all of them. Returns false if the ring itself failed.
+    bool read_all(Request* reqs, size_t count);
+
+private:
+    int ring_fd_ = -1;
+    unsigned entries_ = 0;
+
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_mask_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned* cq_mask_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+};
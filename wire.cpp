@@ -0,0 +1,379 @@
+#include "wire.hpp"
+
+#include "units.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+enum Op : uint8_t {
+    kOpKey = 1,
+    kOpAdd,
+    kOpRemove,
+    kOpInfo,
+    kOpTrack,
+    kOpString,
+    kOpNumber,
+    kOpDrop,
+};
+
+constexpr uint32_t kMaxFrame = 16u << 20;
+
+void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void put_svarint(std::string& out, int64_t v) {
+    put_varint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+void put_str(std::string& out, std::string_view s) {
+    put_varint(out, s.size());
+    out.append(s);
+}
+
+void put_op(std::string& out, Op op, uint32_t dev) {
+    out.push_back(static_cast<char>(op));
+    put_varint(out, dev);
+}
+
+// Bounds-checked reader over one frame; any overrun sets `ok` to false.
+struct Cursor {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            uint8_t b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t svarint() {
+        uint64_t v = varint();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    std::string str() {
+        uint64_t n = varint();
+        if (!ok || n > static_cast<uint64_t>(end - p)) {
+            ok = false;
+            return {};
+        }
+        std::string s(p, n);
+        p += n;
+        return s;
+    }
+
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return static_cast<uint8_t>(*p++);
+    }
+};
+
+void put_info(std::string& out, uint32_t dev, const DeviceInfo& info) {
+    put_op(out, kOpInfo, dev);
+    put_str(out, info.name);
+    put_varint(out, info.channels.size());
+    for (const auto& ch : info.channels) {
+        put_str(out, ch.key);
+        put_str(out, ch.label);
+        put_str(out, ch.unit ? ch.unit : "");
+        put_svarint(out, ch.divisor);
+        put_svarint(out, ch.crit);
+        out.push_back(ch.has_crit ? 1 : 0);
+    }
+}
+
+void put_track(std::string& out, uint32_t dev, const std::vector<uint32_t>& keys) {
+    put_op(out, kOpTrack, dev);
+    put_varint(out, keys.size());
+    for (uint32_t key : keys) put_varint(out, key);
+}
+
+size_t begin_frame(std::string& out, int64_t timestamp_ns) {
+    size_t start = out.size();
+    out.append(4, '\0');
+    put_varint(out, static_cast<uint64_t>(timestamp_ns));
+    return start;
+}
+
+void end_frame(std::string& out, size_t start) {
+    uint32_t len = static_cast<uint32_t>(out.size() - start - 4);
+    for (int i = 0; i < 4; ++i) out[start + i] = static_cast<char>((len >> (8 * i)) & 0xff);
+}
+
+}  // namespace
+
+uint32_t DeltaEncoder::key_id(std::string_view key, std::string& out) {
+    auto it = key_ids_.find(key);
+    if (it != key_ids_.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(keys_.size());
+    keys_.emplace_back(key);
+    key_ids_.emplace(std::string(key), id);
+    out.push_back(static_cast<char>(kOpKey));
+    put_varint(out, id);
+    put_str(out, key);
+    return id;
+}
+
+void DeltaEncoder::encode(const std::vector<Snapshot>& devices, int64_t timestamp_ns, std::string& out) {
+    size_t start = begin_frame(out, timestamp_ns);
+    std::vector<uint32_t> present;
+
+    for (auto& entry : devices_) seen_[entry.first] = false;
+    for (const auto& snap : devices) {
+        auto found = device_ids_.find(snap.path);
+        uint32_t id;
+        if (found == device_ids_.end()) {
+            id = next_device_++;
+            device_ids_.emplace(snap.path, id);
+            seen_.resize(next_device_);
+            WireDevice& dev = devices_[id];
+            dev.path = snap.path;
+            dev.driver = snap.driver ? snap.driver->name() : "";
+            put_op(out, kOpAdd, id);
+            put_str(out, dev.path);
+            put_str(out, dev.driver);
+        } else {
+            id = found->second;
+        }
+        seen_[id] = true;
+        WireDevice& dev = devices_[id];
+
+        if (snap.info != dev.info && snap.info) {
+            dev.info = snap.info;
+            put_info(out, id, *dev.info);
+        }
+
+        present.clear();
+        for (const auto& h : snap.history) present.push_back(key_id(h.first, out));
+        if (present != dev.tracked) {
+            dev.tracked = present;
+            put_track(out, id, dev.tracked);
+        }
+
+        present.clear();
+        for (const auto& kv : snap.values) {
+            uint32_t key = key_id(kv.first, out);
+            present.push_back(key);
+            auto it = dev.values.find(key);
+            if (it != dev.values.end() && it->second == kv.second) continue;
+            dev.values[key] = kv.second;
+            put_op(out, kOpString, id);
+            put_varint(out, key);
+            put_str(out, kv.second);
+        }
+        for (auto it = dev.values.begin(); it != dev.values.end();) {
+            if (std::find(present.begin(), present.end(), it->first) != present.end()) {
+                ++it;
+                continue;
+            }
+            put_op(out, kOpDrop, id);
+            put_varint(out, it->first);
+            it = dev.values.erase(it);
+        }
+
+        present.clear();
+        for (const auto& kv : snap.numbers) {
+            uint32_t key = key_id(kv.first, out);
+            present.push_back(key);
+            auto it = dev.numbers.find(key);
+            int64_t prev = it != dev.numbers.end() ? it->second : 0;
+            if (it != dev.numbers.end() && prev == kv.second) continue;
+            dev.numbers[key] = kv.second;
+            put_op(out, kOpNumber, id);
+            put_varint(out, key);
+            put_svarint(out, static_cast<int64_t>(static_cast<uint64_t>(kv.second) - static_cast<uint64_t>(prev)));
+        }
+        for (auto it = dev.numbers.begin(); it != dev.numbers.end();) {
+            if (std::find(present.begin(), present.end(), it->first) != present.end()) {
+                ++it;
+                continue;
+            }
+            put_op(out, kOpDrop, id);
+            put_varint(out, it->first);
+            it = dev.numbers.erase(it);
+        }
+    }
+
+    for (auto it = devices_.begin(); it != devices_.end();) {
+        if (seen_[it->first]) {
+            ++it;
+            continue;
+        }
+        put_op(out, kOpRemove, it->first);
+        device_ids_.erase(it->second.path);
+        it = devices_.erase(it);
+    }
+    end_frame(out, start);
+}
+
+void DeltaEncoder::encode_full(int64_t timestamp_ns, std::string& out) const {
+    size_t start = begin_frame(out, timestamp_ns);
+    for (uint32_t id = 0; id < keys_.size(); ++id) {
+        out.push_back(static_cast<char>(kOpKey));
+        put_varint(out, id);
+        put_str(out, keys_[id]);
+    }
+    for (const auto& entry : devices_) {
+        uint32_t id = entry.first;
+        const WireDevice& dev = entry.second;
+        put_op(out, kOpAdd, id);
+        put_str(out, dev.path);
+        put_str(out, dev.driver);
+        if (dev.info) put_info(out, id, *dev.info);
+        if (!dev.tracked.empty()) put_track(out, id, dev.tracked);
+        for (const auto& kv : dev.values) {
+            put_op(out, kOpString, id);
+            put_varint(out, kv.first);
+            put_str(out, kv.second);
+        }
+        for (const auto& kv : dev.numbers) {
+            put_op(out, kOpNumber, id);
+            put_varint(out, kv.first);
+            put_svarint(out, kv.second);
+        }
+    }
+    end_frame(out, start);
+}
+
+void DeltaDecoder::reset() {
+    pending_.clear();
+    magic_ = false;
+    keys_.clear();
+    if (!devices_.empty()) ++layout_;
+    devices_.clear();
+}
+
+bool DeltaDecoder::feed(const char* data, size_t len,
+                        const std::function<void(int64_t timestamp_ns)>& on_frame) {
+    pending_.append(data, len);
+    size_t pos = 0;
+
+    if (!magic_) {
+        if (pending_.size() < kWireMagicSize) return true;
+        if (std::memcmp(pending_.data(), kWireMagic, kWireMagicSize) != 0) return false;
+        magic_ = true;
+        pos = kWireMagicSize;
+    }
+
+    while (pending_.size() - pos >= 4) {
+        const unsigned char* h = reinterpret_cast<const unsigned char*>(pending_.data() + pos);
+        uint32_t frame = h[0] | (h[1] << 8) | (h[2] << 16) | (static_cast<uint32_t>(h[3]) << 24);
+        if (frame > kMaxFrame) return false;
+        if (pending_.size() - pos - 4 < frame) break;
+
+        const char* body = pending_.data() + pos + 4;
+        int64_t timestamp_ns = 0;
+        if (!apply(body, body + frame, timestamp_ns)) return false;
+        pos += 4 + frame;
+        if (on_frame) on_frame(timestamp_ns);
+    }
+    pending_.erase(0, pos);
+    return true;
+}
+
+bool DeltaDecoder::apply(const char* p, const char* end, int64_t& timestamp_ns) {
+    Cursor in{p, end};
+    timestamp_ns = static_cast<int64_t>(in.varint());
+
+    while (in.ok && in.p != in.end) {
+        uint8_t op = in.byte();
+        uint32_t id = static_cast<uint32_t>(in.varint());
+        if (!in.ok) return false;
+
+        if (op == kOpKey) {
+            std::string key = in.str();
+            if (id != keys_.size()) return false;
+            keys_.push_back(paths().key(key));
+            continue;
+        }
+        if (op == kOpAdd) {
+            WireDevice& dev = devices_[id];
+            dev = WireDevice{};
+            dev.path = in.str();
+            dev.driver = in.str();
+            ++layout_;
+            continue;
+        }
+
+        auto found = devices_.find(id);
+        if (found == devices_.end()) return false;
+        WireDevice& dev = found->second;
+
+        switch (op) {
+        case kOpRemove:
+            devices_.erase(found);
+            ++layout_;
+            break;
+        case kOpInfo: {
+            auto info = std::make_shared<DeviceInfo>();
+            info->name = in.str();
+            uint64_t count = in.varint();
+            if (count > static_cast<uint64_t>(in.end - in.p)) return false;
+            for (uint64_t i = 0; in.ok && i < count; ++i) {
+                ChannelInfo ch;
+                ch.key = in.str();
+                ch.label = in.str();
+                ch.unit = intern_unit(in.str());
+                ch.divisor = in.svarint();
+                ch.crit = in.svarint();
+                ch.has_crit = in.byte() != 0;
+                info->channels.push_back(std::move(ch));
+            }
+            dev.info = std::move(info);
+            break;
+        }
+        case kOpTrack: {
+            uint64_t count = in.varint();
+            if (count > static_cast<uint64_t>(in.end - in.p)) return false;
+            dev.tracked.clear();
+            for (uint64_t i = 0; in.ok && i < count; ++i) {
+                uint32_t key = static_cast<uint32_t>(in.varint());
+                if (key >= keys_.size()) return false;
+                dev.tracked.push_back(key);
+            }
+            break;
+        }
+        case kOpString: {
+            uint32_t key = static_cast<uint32_t>(in.varint());
+            std::string value = in.str();
+            if (key >= keys_.size()) return false;
+            dev.values[key] = std::move(value);
+            break;
+        }
+        case kOpNumber: {
+            uint32_t key = static_cast<uint32_t>(in.varint());
+            int64_t change = in.svarint();
+            if (key >= keys_.size()) return false;
+            int64_t& value = dev.numbers[key];
+            value = static_cast<int64_t>(static_cast<uint64_t>(value) + static_cast<uint64_t>(change));
+            break;
+        }
+        case kOpDrop: {
+            uint32_t key = static_cast<uint32_t>(in.varint());
+            dev.values.erase(key);
+            dev.numbers.erase(key);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return in.ok;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "sensors.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Delta protocol between kmapd and a TUI client. A stream starts with the
+// 8-byte magic "KMAPDLT1", followed by one frame per sampling tick:
+//   u32 little-endian length of the rest of the frame
+//   varint timestamp_ns
+//   ops until the end of the frame, each a u8 opcode followed by:
+//     Key     varint key id, str key        (defines a key id for the stream)
+//     Add     varint dev, str path, str driver
+//     Remove  varint dev
+//     Info    varint dev, str name, varint channel count, then per channel:
+//             str key, str label, str unit, svarint divisor, svarint crit, u8 has_crit
+//     Track   varint dev, varint count, varint key ids (keys with history)
+//     String  varint dev, varint key, str value
+//     Number  varint dev, varint key, svarint change since the last value
+//     Drop    varint dev, varint key        (the key is no longer reported)
+// Integers are LEB128 varints, svarints zigzag-encoded first; str is a
+// varint length and the bytes. Only what changed since the previous frame
+// is sent, so an idle device costs nothing and a counter costs a byte or two.
+
+constexpr char kWireMagic[] = "KMAPDLT1";
+constexpr size_t kWireMagicSize = 8;
+
+// Last known state of one device on a stream, kept identically by both ends.
+struct WireDevice {
+    std::string path;
+    std::string driver;
+    std::shared_ptr<const DeviceInfo> info;
+    std::vector<uint32_t> tracked;
+    std::map<uint32_t, std::string> values;
+    std::map<uint32_t, int64_t> numbers;
+};
+
+class DeltaEncoder {
+public:
+    // Appends a frame with everything that differs from the previous call.
+    // Devices missing from `devices` are reported removed.
+    void encode(const std::vector<Snapshot>& devices, int64_t timestamp_ns, std::string& out);
+
+    // Appends a frame carrying the whole current state, for a client that
+    // just connected and starts from nothing. Must follow the magic.
+    void encode_full(int64_t timestamp_ns, std::string& out) const;
+
+private:
+    uint32_t key_id(std::string_view key, std::string& out);
+
+    std::vector<std::string> keys_;
+    std::map<std::string, uint32_t, std::less<>> key_ids_;
+    std::map<std::string, uint32_t, std::less<>> device_ids_;
+    std::map<uint32_t, WireDevice> devices_;
+    uint32_t next_device_ = 0;
+    std::vector<bool> seen_;
+};
+
+// Rebuilds the sender's state frame by frame.
+class DeltaDecoder {
+public:
+    // Consumes stream bytes, applying each complete frame and then calling
+    // on_frame. Returns false if the stream is malformed.
+    bool feed(const char* data, size_t len, const std::function<void(int64_t timestamp_ns)>& on_frame);
+
+    // Interned (paths()), so they can key snapshots directly.
+    const std::vector<std::string_view>& keys() const { return keys_; }
+    const std::map<uint32_t, WireDevice>& devices() const { return devices_; }
+
+    // Bumped whenever a device is added or removed.
+    uint64_t layout() const { return layout_; }
+
+    void reset();
+
+private:
+    bool apply(const char* p, const char* end, int64_t& timestamp_ns);
+
+    std::string pending_;
+    bool magic_ = false;
+    std::vector<std::string_view> keys_;
+    std::map<uint32_t, WireDevice> devices_;
+    uint64_t layout_ = 0;
+};